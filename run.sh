@@ -40,8 +40,11 @@ mkdir ${iso_boot_grub}
 touch ${iso_boot_grub}/grub.cfg
 
 if [ ${ARCH} == "x86_64" ]; then
+    # 内核请求的帧缓冲区是可选的，默认保持文本模式，
+    # 需要 fbcon 时去掉 gfxpayload 或设置为具体的分辨率
     echo 'set timeout=15
     set default=0
+    set gfxpayload=text
     menuentry "SimpleKernel" {
        multiboot2 /boot/kernel.bin "KERNEL_BIN"
    }' >${iso_boot_grub}/grub.cfg
@@ -81,11 +81,23 @@ mbi_tag_start:
     .long MULTIBOOT_TAG_TYPE_MODULE
     .long MULTIBOOT_TAG_TYPE_BOOTDEV
     .long MULTIBOOT_TAG_TYPE_MMAP
+    .long MULTIBOOT_TAG_TYPE_FRAMEBUFFER
     .long MULTIBOOT_TAG_TYPE_ELF_SECTIONS
     .long MULTIBOOT_TAG_TYPE_APM
     .long MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR
 .align MULTIBOOT_HEADER_ALIGN
 mbi_tag_end:
+# 帧缓冲区，分辨率由引导程序决定，优先 32 位色
+# 可选，GRUB 中设置 gfxpayload=text 时保持文本模式，见 run.sh
+fb_tag_start:
+    .short MULTIBOOT_HEADER_TAG_FRAMEBUFFER
+    .short MULTIBOOT_HEADER_TAG_OPTIONAL
+    .long fb_tag_end - fb_tag_start
+    .long 0
+    .long 0
+    .long 32
+.align MULTIBOOT_HEADER_ALIGN
+fb_tag_end:
 	.short MULTIBOOT_HEADER_TAG_END
     .short 0
     .long 8
@@ -121,6 +133,7 @@ multiboot_entry:
 .size _start, . - _start
 
 .section .data
+.global STACK
 STACK:
     .skip 16384
 STACK_TOP:
@@ -185,6 +185,18 @@ static inline uint32_t cpu_read_cr3(void) {
     return cr3;
 }
 
+// 写入 CR0
+static inline void cpu_write_cr0(uint32_t cr0) {
+    __asm__ volatile("mov %0, %%cr0" : : "r"(cr0) : "memory");
+    return;
+}
+
+// 写入 CR3，同时会刷新所有非全局页的 TLB
+static inline void cpu_write_cr3(uint32_t cr3) {
+    __asm__ volatile("mov %0, %%cr3" : : "r"(cr3) : "memory");
+    return;
+}
+
 // 切换内核栈
 static inline void cpu_switch_stack(ptr_t stack_top) {
     __asm__ volatile("mov %0, %%esp" : : "r"(stack_top));
@@ -199,6 +211,22 @@ static inline uint32_t cpu_read_cr4(void) {
     return cr4;
 }
 
+// 写入 CR4
+static inline void cpu_write_cr4(uint32_t cr4) {
+    __asm__ volatile("mov %0, %%cr4" : : "r"(cr4) : "memory");
+    return;
+}
+
+// CPUID 指令
+// leaf: EAX 输入，subleaf: ECX 输入
+static inline void cpu_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+                             uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+    __asm__ volatile("cpuid"
+                     : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                     : "a"(leaf), "c"(subleaf));
+    return;
+}
+
 // Identification flag
 //程序能够设置或清除这个标志指示了处理器对 CPUID 指令的支持。
 static inline bool FL_ID_status(void) {
@@ -323,11 +351,59 @@ static inline bool EFLAGS_CF_status(void) {
     return (eflags & EFLAGS_CF);
 }
 
+// CPUID.01H:EDX 特性位
+// 支持 4MB 大页
+#define CPUID_EDX_PSE 0x00000008
+// 支持全局页
+#define CPUID_EDX_PGE 0x00002000
+// 支持 FXSAVE/FXRSTOR
+#define CPUID_EDX_FXSR 0x01000000
+// 支持 SSE
+#define CPUID_EDX_SSE 0x02000000
+// 支持 SSE2
+#define CPUID_EDX_SSE2 0x04000000
+// CPUID.(EAX=07H,ECX=0):EBX 特性位
+// 支持增强的 rep movsb/stosb (ERMS)
+#define CPUID_07_EBX_ERMS 0x00000200
+
+// CPU 是否支持 ERMS
+static inline bool cpu_has_erms(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    if (eax < 7) {
+        return false;
+    }
+    cpu_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+    return (ebx & CPUID_07_EBX_ERMS) ? true : false;
+}
+
+// 刷新指定地址的 TLB 项
 static inline void CPU_INVLPG(ptr_t addr) {
     __asm__ volatile("invlpg (%0)" : : "r"(addr) : "memory");
     return;
 }
 
+// 重新加载 CR3，刷新全部非全局页的 TLB
+static inline void CPU_FLUSH_TLB(void) {
+    cpu_write_cr3(cpu_read_cr3());
+    return;
+}
+
+// 读取时间戳计数器
+static inline uint64_t cpu_rdtsc(void) {
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// 支持的最大 CPU 数量，目前只有单核
+#define CPU_MAX (1)
+
+// 获取当前 CPU 编号，用于索引 per-CPU 数据
+static inline uint32_t cpu_get_id(void) {
+    return 0;
+}
+
 static inline bool CR4_VME_status(void) {
     uint32_t cr4 = cpu_read_cr4();
     return (cr4 & CR4_VME);
@@ -11,6 +11,9 @@ extern "C" {
 #include "stdio.h"
 #include "intr.h"
 #include "cpu.hpp"
+#include "klog.h"
+#include "console.h"
+#include "serial.h"
 #include "debug.h"
 
 void debug_init(ptr_t magic __UNUSED__, ptr_t addr __UNUSED__) {
@@ -36,7 +39,17 @@ void print_cur_status() {
     ++round;
 }
 
+void debug_emergency(void) {
+    console_set_deferred(false);
+    serial_set_polled(true);
+    // 输出缓冲区中的日志，即使空闲循环的 klog_flush 正被打断
+    klog_emergency();
+    return;
+}
+
 void panic(const char *msg) {
+    // 不再依赖中断，日志立即输出并写入显存与串口
+    debug_emergency();
     printk("*** System panic: %s\n", msg);
     print_stack(10);
     printk("***\n");
@@ -0,0 +1,81 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// fpu.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "cpu.hpp"
+#include "sync.hpp"
+#include "fpu.h"
+
+// CPU 是否支持 SSE2
+static bool fpu_sse2 = false;
+// 每个 CPU 进入 kernel_fpu_begin 前的状态
+static fpu_state_t fpu_saved[CPU_MAX];
+// 每个 CPU 是否正在使用 SSE 寄存器，防止中断中嵌套使用
+static bool fpu_in_use[CPU_MAX];
+
+void fpu_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    uint32_t need = CPUID_EDX_FXSR | CPUID_EDX_SSE | CPUID_EDX_SSE2;
+    if ((edx & need) != need) {
+        printk_info("fpu_init: SSE2 not supported\n");
+        return;
+    }
+    // 使用 FPU 指令，不使用模拟，不触发 #NM
+    uint32_t cr0 = cpu_read_cr0();
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    cpu_write_cr0(cr0);
+    // 开启 FXSAVE/FXRSTOR 与 SSE 异常
+    cpu_write_cr4(cpu_read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+    __asm__ volatile("fninit");
+    for (uint32_t i = 0; i < CPU_MAX; i++) {
+        fpu_in_use[i] = false;
+    }
+    fpu_sse2 = true;
+    string_set_simd(&fpu_simd_string);
+    printk_info("fpu_init: SSE2 enabled\n");
+    return;
+}
+
+bool fpu_available(void) {
+    return fpu_sse2;
+}
+
+bool kernel_fpu_begin(void) {
+    if (fpu_sse2 == false) {
+        return false;
+    }
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    uint32_t id = cpu_get_id();
+    // 被中断的代码正在使用 SSE 寄存器
+    if (fpu_in_use[id] == true) {
+        local_intr_restore(intr_flag);
+        return false;
+    }
+    fpu_in_use[id] = true;
+    __asm__ volatile("fxsave %0" : "=m"(fpu_saved[id]));
+    local_intr_restore(intr_flag);
+    return true;
+}
+
+void kernel_fpu_end(void) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    uint32_t id = cpu_get_id();
+    __asm__ volatile("fxrstor %0" : : "m"(fpu_saved[id]));
+    fpu_in_use[id] = false;
+    local_intr_restore(intr_flag);
+    return;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,153 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// simd.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "string.h"
+#include "fpu.h"
+
+// 内核以 -mno-sse 编译，编译器不会使用 xmm 寄存器，
+// 因此以下内联汇编不需要（也不能）声明对 xmm 寄存器的修改
+
+static size_t simd_memcpy(void *dest, const void *src, size_t len);
+static size_t simd_memset(void *dest, int val, size_t len);
+static size_t simd_memcmp(const void *src1, const void *src2, size_t len);
+
+const string_simd_t fpu_simd_string = {
+    .threshold          = FPU_SIMD_THRESHOLD,
+    .string_simd_memcpy = simd_memcpy,
+    .string_simd_memset = simd_memset,
+    .string_simd_memcmp = simd_memcmp,
+};
+
+// 每次循环复制 64 字节，目标地址已 16 字节对齐
+// 返回已复制的字节数
+static size_t simd_memcpy(void *dest, const void *src, size_t len) {
+    if (kernel_fpu_begin() == false) {
+        return 0;
+    }
+    uint8_t *      dst = (uint8_t *)dest;
+    const uint8_t *sr  = (const uint8_t *)src;
+    // 先用一次非对齐存储复制开头的 16 字节，之后从对齐处开始
+    size_t head = (-(ptr_t)dst) & 15;
+    __asm__ volatile("movdqu (%0), %%xmm0\n\t"
+                     "movdqu %%xmm0, (%1)"
+                     :
+                     : "r"(sr), "r"(dst)
+                     : "memory");
+    size_t blocks = (len - head) >> 6;
+    dst += head;
+    sr += head;
+    if (len >= FPU_NT_THRESHOLD) {
+        for (size_t i = 0; i < blocks; i++, dst += 64, sr += 64) {
+            __asm__ volatile("movdqu (%0), %%xmm0\n\t"
+                             "movdqu 16(%0), %%xmm1\n\t"
+                             "movdqu 32(%0), %%xmm2\n\t"
+                             "movdqu 48(%0), %%xmm3\n\t"
+                             "movntdq %%xmm0, (%1)\n\t"
+                             "movntdq %%xmm1, 16(%1)\n\t"
+                             "movntdq %%xmm2, 32(%1)\n\t"
+                             "movntdq %%xmm3, 48(%1)"
+                             :
+                             : "r"(sr), "r"(dst)
+                             : "memory");
+        }
+        // 非临时存储是弱序的
+        __asm__ volatile("sfence" : : : "memory");
+    }
+    else {
+        for (size_t i = 0; i < blocks; i++, dst += 64, sr += 64) {
+            __asm__ volatile("movdqu (%0), %%xmm0\n\t"
+                             "movdqu 16(%0), %%xmm1\n\t"
+                             "movdqu 32(%0), %%xmm2\n\t"
+                             "movdqu 48(%0), %%xmm3\n\t"
+                             "movdqa %%xmm0, (%1)\n\t"
+                             "movdqa %%xmm1, 16(%1)\n\t"
+                             "movdqa %%xmm2, 32(%1)\n\t"
+                             "movdqa %%xmm3, 48(%1)"
+                             :
+                             : "r"(sr), "r"(dst)
+                             : "memory");
+        }
+    }
+    kernel_fpu_end();
+    return head + (blocks << 6);
+}
+
+// 每次循环填充 64 字节，返回已填充的字节数
+static size_t simd_memset(void *dest, int val, size_t len) {
+    if (kernel_fpu_begin() == false) {
+        return 0;
+    }
+    uint8_t *dst  = (uint8_t *)dest;
+    uint32_t word = (uint8_t)val * 0x01010101UL;
+    size_t   head = (-(ptr_t)dst) & 15;
+    __asm__ volatile("movd %0, %%xmm0\n\t"
+                     "pshufd $0, %%xmm0, %%xmm0\n\t"
+                     "movdqu %%xmm0, (%1)"
+                     :
+                     : "r"(word), "r"(dst)
+                     : "memory");
+    size_t blocks = (len - head) >> 6;
+    dst += head;
+    if (len >= FPU_NT_THRESHOLD) {
+        for (size_t i = 0; i < blocks; i++, dst += 64) {
+            __asm__ volatile("movntdq %%xmm0, (%0)\n\t"
+                             "movntdq %%xmm0, 16(%0)\n\t"
+                             "movntdq %%xmm0, 32(%0)\n\t"
+                             "movntdq %%xmm0, 48(%0)"
+                             :
+                             : "r"(dst)
+                             : "memory");
+        }
+        __asm__ volatile("sfence" : : : "memory");
+    }
+    else {
+        for (size_t i = 0; i < blocks; i++, dst += 64) {
+            __asm__ volatile("movdqa %%xmm0, (%0)\n\t"
+                             "movdqa %%xmm0, 16(%0)\n\t"
+                             "movdqa %%xmm0, 32(%0)\n\t"
+                             "movdqa %%xmm0, 48(%0)"
+                             :
+                             : "r"(dst)
+                             : "memory");
+        }
+    }
+    kernel_fpu_end();
+    return head + (blocks << 6);
+}
+
+// 每次比较 16 字节，遇到不同时停止
+// 返回的长度之前的内容都相等
+static size_t simd_memcmp(const void *src1, const void *src2, size_t len) {
+    if (kernel_fpu_begin() == false) {
+        return 0;
+    }
+    const uint8_t *s1   = (const uint8_t *)src1;
+    const uint8_t *s2   = (const uint8_t *)src2;
+    size_t         done = 0;
+    for (; done + 16 <= len; done += 16) {
+        uint32_t mask;
+        __asm__ volatile("movdqu (%1), %%xmm0\n\t"
+                         "movdqu (%2), %%xmm1\n\t"
+                         "pcmpeqb %%xmm1, %%xmm0\n\t"
+                         "pmovmskb %%xmm0, %0"
+                         : "=r"(mask)
+                         : "r"(s1 + done), "r"(s2 + done)
+                         : "memory");
+        if (mask != 0xFFFF) {
+            break;
+        }
+    }
+    kernel_fpu_end();
+    return done;
+}
+
+#ifdef __cplusplus
+}
+#endif
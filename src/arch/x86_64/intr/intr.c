@@ -12,6 +12,7 @@ extern "C" {
 #include "port.hpp"
 #include "intr.h"
 #include "8259A.h"
+#include "debug.h"
 
 // 中断描述符表
 static idt_entry_t idt_entries[INTERRUPT_MAX] __attribute__((aligned(16)));
@@ -70,6 +71,7 @@ void isr_handler(pt_regs_t *regs) {
         interrupt_handlers[regs->int_no](regs);
     }
     else {
+        debug_emergency();
         printk("Unhandled interrupt: %d %s\n", regs->int_no,
                intrname(regs->int_no));
         cpu_hlt();
@@ -152,6 +154,8 @@ void intr_init(void) {
 static void die(char *str, uint32_t oesp, uint32_t int_no) {
     // uint32_t * old_esp = (uint32_t *)oesp;
     pt_regs_t *old_esp = (pt_regs_t *)oesp;
+    // 之后会停机，寄存器信息不能留在日志缓冲区中
+    debug_emergency();
     printk_color(red, "%s\t: %d\n\r", str, int_no);
     printk_color(light_red, "die_Unuseable.\n");
     // cs::EIP
@@ -260,6 +264,7 @@ void page_fault(pt_regs_t *regs) {
     uint32_t cr2;
     asm volatile("mov %%cr2,%0" : "=r"(cr2));
 #endif
+    debug_emergency();
     printk("Page fault at 0x%08X, virtual faulting address 0x%08X\n", regs->eip,
            cr2);
     printk_err("Error code: 0x%08X\n", regs->err_code);
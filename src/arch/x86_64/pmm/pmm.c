@@ -12,6 +12,7 @@ extern "C" {
 #include "string.h"
 #include "pmm.h"
 #include "firstfit.h"
+#include "memprof.h"
 
 static const pmm_manage_t *pmm_manager = &firstfit_manage;
 
@@ -101,7 +102,7 @@ void pmm_zone_init(e820map_t *e820map) {
     }
     // 设置分区的总页面和空闲页面信息
     mem_zone[DMA].all_pages = count_dma;
-    printk_info("%d\n", mem_zone[DMA].all_pages);
+    printk_debug("%d\n", mem_zone[DMA].all_pages);
     mem_zone[DMA].free_pages     = free_dma;
     mem_zone[NORMAL].all_pages   = count_normal;
     mem_zone[NORMAL].free_pages  = free_normal;
@@ -129,26 +130,28 @@ void pmm_init() {
     pmm_get_ram_info(&e820map);
     pmm_zone_init(&e820map);
     pmm_mamage_init();
-    printk_info("mem_DMA free_pages: 0x%X\n", mem_zone[DMA].free_pages);
-    printk_info("mem_DMA pages_min: 0x%X\n", mem_zone[DMA].pages_min);
-    printk_info("mem_DMA pages_low: 0x%X\n", mem_zone[DMA].pages_low);
-    printk_info("mem_DMA pages_high: 0x%X\n", mem_zone[DMA].pages_high);
-    printk_info("mem_DMA need_balance: 0x%X\n", mem_zone[DMA].need_balance);
-    printk_info("mem_DMA all_pages: 0x%X\n", mem_zone[DMA].all_pages);
-    printk_info("mem_NORMAL free_pages: 0x%X\n", mem_zone[NORMAL].free_pages);
-    printk_info("mem_NORMAL pages_min: 0x%X\n", mem_zone[NORMAL].pages_min);
-    printk_info("mem_NORMAL pages_low: 0x%X\n", mem_zone[NORMAL].pages_low);
-    printk_info("mem_NORMAL pages_high: 0x%X\n", mem_zone[NORMAL].pages_high);
-    printk_info("mem_NORMAL need_balance: 0x%X\n",
-                mem_zone[NORMAL].need_balance);
-    printk_info("mem_NORMAL all_pages: 0x%X\n", mem_zone[NORMAL].all_pages);
-    printk_info("mem_HIGHMEM free_pages: 0x%X\n", mem_zone[HIGHMEM].free_pages);
-    printk_info("mem_HIGHMEM pages_min: 0x%X\n", mem_zone[HIGHMEM].pages_min);
-    printk_info("mem_HIGHMEM pages_low: 0x%X\n", mem_zone[HIGHMEM].pages_low);
-    printk_info("mem_HIGHMEM pages_high: 0x%X\n", mem_zone[HIGHMEM].pages_high);
-    printk_info("mem_HIGHMEM need_balance: 0x%X\n",
-                mem_zone[HIGHMEM].need_balance);
-    printk_info("mem_HIGHMEM all_pages: 0x%X\n", mem_zone[HIGHMEM].all_pages);
+    printk_debug("mem_DMA free_pages: 0x%X\n", mem_zone[DMA].free_pages);
+    printk_debug("mem_DMA pages_min: 0x%X\n", mem_zone[DMA].pages_min);
+    printk_debug("mem_DMA pages_low: 0x%X\n", mem_zone[DMA].pages_low);
+    printk_debug("mem_DMA pages_high: 0x%X\n", mem_zone[DMA].pages_high);
+    printk_debug("mem_DMA need_balance: 0x%X\n", mem_zone[DMA].need_balance);
+    printk_debug("mem_DMA all_pages: 0x%X\n", mem_zone[DMA].all_pages);
+    printk_debug("mem_NORMAL free_pages: 0x%X\n", mem_zone[NORMAL].free_pages);
+    printk_debug("mem_NORMAL pages_min: 0x%X\n", mem_zone[NORMAL].pages_min);
+    printk_debug("mem_NORMAL pages_low: 0x%X\n", mem_zone[NORMAL].pages_low);
+    printk_debug("mem_NORMAL pages_high: 0x%X\n", mem_zone[NORMAL].pages_high);
+    printk_debug("mem_NORMAL need_balance: 0x%X\n",
+                 mem_zone[NORMAL].need_balance);
+    printk_debug("mem_NORMAL all_pages: 0x%X\n", mem_zone[NORMAL].all_pages);
+    printk_debug("mem_HIGHMEM free_pages: 0x%X\n",
+                 mem_zone[HIGHMEM].free_pages);
+    printk_debug("mem_HIGHMEM pages_min: 0x%X\n", mem_zone[HIGHMEM].pages_min);
+    printk_debug("mem_HIGHMEM pages_low: 0x%X\n", mem_zone[HIGHMEM].pages_low);
+    printk_debug("mem_HIGHMEM pages_high: 0x%X\n",
+                 mem_zone[HIGHMEM].pages_high);
+    printk_debug("mem_HIGHMEM need_balance: 0x%X\n",
+                 mem_zone[HIGHMEM].need_balance);
+    printk_debug("mem_HIGHMEM all_pages: 0x%X\n", mem_zone[HIGHMEM].all_pages);
     printk_info("Total free phy pages: 0x%X\n",
                 mem_zone[DMA].free_pages + mem_zone[NORMAL].free_pages +
                     mem_zone[HIGHMEM].free_pages);
@@ -159,21 +162,41 @@ void pmm_init() {
 ptr_t pmm_alloc(uint32_t byte, int8_t zone) {
     ptr_t page;
     page = pmm_manager->pmm_manage_alloc(byte, zone);
+    if (page != (ptr_t)-1) {
+        memprof_alloc(MEMPROF_PAGE, page, byte,
+                      (ptr_t)__builtin_return_address(0));
+    }
     return page;
 }
 
 ptr_t pmm_alloc_page(uint32_t pages, int8_t zone) {
     ptr_t page;
     page = pmm_manager->pmm_manage_alloc(PMM_PAGE_SIZE * pages, zone);
+    if (page != (ptr_t)-1) {
+        memprof_alloc(MEMPROF_PAGE, page, PMM_PAGE_SIZE * pages,
+                      (ptr_t)__builtin_return_address(0));
+    }
+    return page;
+}
+
+ptr_t pmm_alloc_page_align(uint32_t pages, uint32_t align, int8_t zone) {
+    ptr_t page;
+    page = pmm_manager->pmm_manage_alloc_align(pages, align, zone);
+    if (page != (ptr_t)-1) {
+        memprof_alloc(MEMPROF_PAGE, page, PMM_PAGE_SIZE * pages,
+                      (ptr_t)__builtin_return_address(0));
+    }
     return page;
 }
 
 void pmm_free(ptr_t addr, uint32_t byte, int8_t zone) {
+    memprof_free(MEMPROF_PAGE, addr);
     pmm_manager->pmm_manage_free(addr, byte, zone);
     return;
 }
 
 void pmm_free_page(ptr_t addr, uint32_t pages, int8_t zone) {
+    memprof_free(MEMPROF_PAGE, addr);
     pmm_manager->pmm_manage_free(addr, pages * PMM_PAGE_SIZE, zone);
     return;
 }
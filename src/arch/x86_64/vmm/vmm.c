@@ -0,0 +1,335 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// vmm.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "assert.h"
+#include "cpu.hpp"
+#include "sync.hpp"
+#include "vmm.h"
+
+// 内核页目录
+pgd_t pgd_kernel[VMM_ENTRIES_PER_TABLE] __attribute__((aligned(4096)));
+// 当前使用的页目录
+pgd_t *pgd_current;
+// 是否支持 4MB 大页
+static bool vmm_pse;
+
+// TLB 待刷新队列
+static ptr_t tlb_pending[VMM_TLB_BATCH_MAX];
+// 待刷新数量，超过 VMM_TLB_BATCH_MAX 后只计数，刷新时重新加载 CR3
+static uint32_t tlb_pending_count;
+
+// 预先清零的页表页缓存，以单链表串联，链接指针存放在页的第一个字中
+static ptr_t pgtable_pool;
+// 缓存中的页数
+static uint32_t pgtable_pool_count;
+
+// 从 pmm 分配一个页并清零
+static pte_t *pgtable_new(void) {
+    ptr_t pa = pmm_alloc_page(1, NORMAL);
+    if (pa == (ptr_t)-1) {
+        return NULL;
+    }
+    bzero((void *)pa, VMM_PAGE_SIZE);
+    return (pte_t *)pa;
+}
+
+// 将一个已清零的页放入缓存，调用前需关中断
+static void pgtable_push(pte_t *pte) {
+    *(ptr_t *)pte = pgtable_pool;
+    pgtable_pool  = (ptr_t)pte;
+    pgtable_pool_count++;
+    return;
+}
+
+pte_t *vmm_pgtable_alloc(void) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    pte_t *pte = (pte_t *)pgtable_pool;
+    if (pte != NULL) {
+        pgtable_pool = *(ptr_t *)pte;
+        pgtable_pool_count--;
+    }
+    local_intr_restore(intr_flag);
+    // 缓存为空时退回到 pmm，并当场清零
+    if (pte == NULL) {
+        return pgtable_new();
+    }
+    // 只有链接指针需要清除
+    *(ptr_t *)pte = 0;
+    return pte;
+}
+
+void vmm_pgtable_free(pte_t *pte) {
+    // 在释放时清零，分配时不再需要
+    bzero(pte, VMM_PAGE_SIZE);
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    if (pgtable_pool_count < VMM_PGTABLE_POOL_HIGH) {
+        pgtable_push(pte);
+        pte = NULL;
+    }
+    local_intr_restore(intr_flag);
+    if (pte != NULL) {
+        pmm_free_page((ptr_t)pte, 1, NORMAL);
+    }
+    return;
+}
+
+void vmm_pgtable_refill(void) {
+    // 不加锁的快速检查，空闲时反复调用的开销很小
+    if (pgtable_pool_count >= VMM_PGTABLE_POOL_LOW) {
+        return;
+    }
+    while (pgtable_pool_count < VMM_PGTABLE_POOL_HIGH) {
+        // 先检查空闲页数，NORMAL 用完时直接返回，避免 pmm 每次都报错
+        if (pmm_free_pages_count(NORMAL) == 0) {
+            return;
+        }
+        pte_t *pte = pgtable_new();
+        if (pte == NULL) {
+            return;
+        }
+        bool intr_flag = false;
+        local_intr_store(intr_flag);
+        pgtable_push(pte);
+        local_intr_restore(intr_flag);
+    }
+    return;
+}
+
+uint32_t vmm_pgtable_pool_count(void) {
+    return pgtable_pool_count;
+}
+
+// 建立直接映射区
+static void vmm_direct_map_init(bool pse, uint32_t global) {
+    if (pse == true) {
+        // 直接使用 4MB 大页，不需要页表
+        for (ptr_t addr = 0; addr < VMM_DIRECT_MAP_END;
+             addr += VMM_LARGE_PAGE_SIZE) {
+            pgd_kernel[VMM_PGD_INDEX(addr)] =
+                addr | VMM_PAGE_KERNEL | VMM_PAGE_LARGE | global;
+        }
+        return;
+    }
+    // 不支持 PSE 时使用 4KB 页，页表一次性连续分配
+    uint32_t tables = VMM_DIRECT_MAP_END / VMM_LARGE_PAGE_SIZE;
+    pte_t *  pte    = (pte_t *)pmm_alloc_page(tables, NORMAL);
+    assert(pte != (pte_t *)-1, "vmm_direct_map_init: No enough phy mem.\n");
+    for (ptr_t addr = 0; addr < VMM_DIRECT_MAP_END; addr += VMM_PAGE_SIZE) {
+        pte[addr / VMM_PAGE_SIZE] = addr | VMM_PAGE_KERNEL | global;
+    }
+    for (uint32_t i = 0; i < tables; i++) {
+        pgd_kernel[i] =
+            (ptr_t)&pte[i * VMM_ENTRIES_PER_TABLE] | VMM_PAGE_KERNEL;
+    }
+    return;
+}
+
+void vmm_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    bool     pse    = (edx & CPUID_EDX_PSE) ? true : false;
+    uint32_t global = (edx & CPUID_EDX_PGE) ? VMM_PAGE_GLOBAL : 0;
+
+    vmm_pse = pse;
+    bzero(pgd_kernel, sizeof(pgd_kernel));
+    vmm_direct_map_init(pse, global);
+    tlb_pending_count  = 0;
+    pgtable_pool       = 0;
+    pgtable_pool_count = 0;
+    vmm_pgtable_refill();
+
+    // 开启 PSE、PGE
+    uint32_t cr4 = cpu_read_cr4();
+    if (pse == true) {
+        cr4 |= CR4_PSE;
+    }
+    if (global != 0) {
+        cr4 |= CR4_PGE;
+    }
+    cpu_write_cr4(cr4);
+    // 最后一项指向页目录自身，所有页表项都可以通过固定的虚拟地址访问
+    pgd_kernel[VMM_RECURSIVE_INDEX] = (ptr_t)pgd_kernel | VMM_PAGE_KERNEL;
+    // 加载页目录并开启分页
+    vmm_switch_pgd(pgd_kernel);
+    cpu_write_cr0(cpu_read_cr0() | CR0_PG);
+
+    printk_info("vmm_init\n");
+    return;
+}
+
+// 获取 va 的页表项地址，调用者需保证页目录项存在且不是大页
+// 当前地址空间通过递归映射直接访问，其它地址空间的页表位于直接映射区
+static inline pte_t *vmm_pte_addr(pgd_t *pgd, ptr_t va) {
+    if (pgd == pgd_current) {
+        return VMM_RECURSIVE_PTE(va);
+    }
+    return &((pte_t *)(pgd[VMM_PGD_INDEX(va)] & VMM_PAGE_MASK))[VMM_PTE_INDEX(
+        va)];
+}
+
+void vmm_switch_pgd(pgd_t *pgd) {
+    pgd_current = pgd;
+    cpu_write_cr3((ptr_t)pgd);
+    return;
+}
+
+pte_t *vmm_get_pte(pgd_t *pgd, ptr_t va, bool create) {
+    pgd_t *pde = &pgd[VMM_PGD_INDEX(va)];
+    // 已经被大页映射
+    if (*pde & VMM_PAGE_LARGE) {
+        printk_err("vmm_get_pte: 0x%08X is mapped by a large page\n", va);
+        return NULL;
+    }
+    if ((*pde & VMM_PAGE_PRESENT) == 0) {
+        if (create == false) {
+            return NULL;
+        }
+        pte_t *new_pte = vmm_pgtable_alloc();
+        if (new_pte == NULL) {
+            return NULL;
+        }
+        *pde = (ptr_t)new_pte | VMM_PAGE_KERNEL;
+        // 新页表在递归映射区中的地址可能残留旧的 TLB 项
+        if (pgd == pgd_current) {
+            CPU_INVLPG((ptr_t)VMM_RECURSIVE_PTE(va & VMM_LARGE_PAGE_MASK));
+        }
+    }
+    return vmm_pte_addr(pgd, va);
+}
+
+bool vmm_map(pgd_t *pgd, ptr_t va, ptr_t pa, uint32_t flags) {
+    pte_t *pte = vmm_get_pte(pgd, va, true);
+    if (pte == NULL) {
+        return false;
+    }
+    // 用户页需要页目录项同样允许用户访问
+    pgd[VMM_PGD_INDEX(va)] |= (flags & VMM_PAGE_USER);
+    pte_t old = *pte;
+    *pte      = (pa & VMM_PAGE_MASK) | flags;
+    // 覆盖了有效的映射，需要立即刷新
+    if (old & VMM_PAGE_PRESENT) {
+        CPU_INVLPG(va);
+    }
+    return true;
+}
+
+bool vmm_map_large(pgd_t *pgd, ptr_t va, ptr_t pa, uint32_t flags) {
+    if (vmm_pse == false) {
+        return false;
+    }
+    pgd_t *pde = &pgd[VMM_PGD_INDEX(va)];
+    pgd_t  old = *pde;
+    *pde       = (pa & VMM_LARGE_PAGE_MASK) | flags | VMM_PAGE_LARGE;
+    if ((old & VMM_PAGE_PRESENT) == 0) {
+        return true;
+    }
+    if (old & VMM_PAGE_LARGE) {
+        CPU_INVLPG(va);
+        return true;
+    }
+    // 原页表中最多有 1024 项，以及递归映射区中的一项，直接全部刷新
+    CPU_FLUSH_TLB();
+    vmm_pgtable_free((pte_t *)(old & VMM_PAGE_MASK));
+    return true;
+}
+
+bool vmm_has_large_page(void) {
+    return vmm_pse;
+}
+
+void vmm_unmap(pgd_t *pgd, ptr_t va) {
+    pgd_t pde = pgd[VMM_PGD_INDEX(va)];
+    if ((pde & VMM_PAGE_PRESENT) == 0) {
+        return;
+    }
+    // 取消整个大页的映射
+    if (pde & VMM_PAGE_LARGE) {
+        pgd[VMM_PGD_INDEX(va)] = 0;
+        vmm_tlb_queue(va);
+        return;
+    }
+    pte_t *pte = vmm_pte_addr(pgd, va);
+    if ((*pte & VMM_PAGE_PRESENT) == 0) {
+        return;
+    }
+    *pte = 0;
+    vmm_tlb_queue(va);
+    return;
+}
+
+bool vmm_protect(pgd_t *pgd, ptr_t va, uint32_t flags) {
+    pgd_t pde = pgd[VMM_PGD_INDEX(va)];
+    if ((pde & VMM_PAGE_PRESENT) == 0 || (pde & VMM_PAGE_LARGE)) {
+        return false;
+    }
+    pte_t *pte = vmm_pte_addr(pgd, va);
+    if ((*pte & VMM_PAGE_PRESENT) == 0) {
+        return false;
+    }
+    pgd[VMM_PGD_INDEX(va)] |= (flags & VMM_PAGE_USER);
+    *pte = (*pte & VMM_PAGE_MASK) | flags;
+    // 权限可能被收紧，需要立即刷新
+    CPU_INVLPG(va);
+    return true;
+}
+
+bool vmm_get_mapping(pgd_t *pgd, ptr_t va, ptr_t *pa) {
+    pgd_t pde = pgd[VMM_PGD_INDEX(va)];
+    if ((pde & VMM_PAGE_PRESENT) == 0) {
+        return false;
+    }
+    if (pde & VMM_PAGE_LARGE) {
+        *pa = (pde & VMM_LARGE_PAGE_MASK) | (va & ~VMM_LARGE_PAGE_MASK);
+        return true;
+    }
+    pte_t pte = *vmm_pte_addr(pgd, va);
+    if ((pte & VMM_PAGE_PRESENT) == 0) {
+        return false;
+    }
+    *pa = (pte & VMM_PAGE_MASK) | (va & ~VMM_PAGE_MASK);
+    return true;
+}
+
+void vmm_tlb_queue(ptr_t va) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    if (tlb_pending_count < VMM_TLB_BATCH_MAX) {
+        tlb_pending[tlb_pending_count] = va & VMM_PAGE_MASK;
+    }
+    // 超出队列长度后只计数，刷新时改为重新加载 CR3
+    if (tlb_pending_count <= VMM_TLB_BATCH_MAX) {
+        tlb_pending_count++;
+    }
+    local_intr_restore(intr_flag);
+    return;
+}
+
+void vmm_tlb_flush(void) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    if (tlb_pending_count > VMM_TLB_BATCH_MAX) {
+        CPU_FLUSH_TLB();
+    }
+    else {
+        for (uint32_t i = 0; i < tlb_pending_count; i++) {
+            CPU_INVLPG(tlb_pending[i]);
+        }
+    }
+    tlb_pending_count = 0;
+    local_intr_restore(intr_flag);
+    return;
+}
+
+#ifdef __cplusplus
+}
+#endif
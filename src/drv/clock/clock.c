@@ -12,6 +12,7 @@ extern "C" {
 #include "stdio.h"
 #include "stddef.h"
 #include "port.hpp"
+#include "console.h"
 #include "clock.h"
 
 void clock_init(void) {
@@ -24,11 +25,19 @@ void clock_init(void) {
     // 分别写入低字节和高字节
     outb(IO_TIMER, low);
     outb(IO_TIMER, hign);
+    register_interrupt_handler(IRQ0, &clock_handler);
+    enable_irq(IRQ0);
 
     printk_info("clock_init\n");
     return;
 }
 
+void clock_handler(pt_regs_t *regs __UNUSED__) {
+    // 延迟模式下控制台的输出在这里写入显存
+    console_flush();
+    return;
+}
+
 #ifdef __cplusplus
 }
 #endif
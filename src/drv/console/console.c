@@ -12,6 +12,8 @@ extern "C" {
 #include "string.h"
 #include "stdio.h"
 #include "port.hpp"
+#include "sync.hpp"
+#include "klog.h"
 #include "console.h"
 
 // 命令行行数
@@ -21,8 +23,79 @@ static size_t console_column;
 // 当前命令行颜色
 static uint8_t console_color;
 // 显存地址
-static uint16_t *console_buffer __attribute__((unused)) =
-    (uint16_t *)VGA_MEM_BASE;
+static uint16_t *const console_vga = (uint16_t *)VGA_MEM_BASE;
+// 显存的影子缓冲区，输出先写到这里，再将修改过的行批量写入显存
+static uint16_t console_buffer[VGA_MEM_SIZE / sizeof(uint16_t)];
+// 最后一次写入 VGA 的光标位置，与之相同时不再写端口
+static uint16_t console_cursor;
+// 显存可容纳的行数，显存作为环形缓冲区使用
+#define CONSOLE_MEM_ROWS (VGA_MEM_SIZE / sizeof(uint16_t) / VGA_WIDTH)
+// 屏幕第一行在显存中的行号，始终满足 console_top + VGA_HEIGHT <= 显存行数
+static size_t console_top;
+// 最后一次写入 CRTC 的起始行
+static size_t console_start;
+// 影子缓冲区中修改过、尚未写入显存的行 [first, last)
+static size_t console_dirty_first;
+static size_t console_dirty_last;
+// 为 true 时只在 console_flush 时写入显存，否则每次输出后立即写入
+static bool console_deferred;
+// 显示设备，为 NULL 时直接写 VGA 显存
+static const console_backend_t *console_backend;
+
+// 记录第 row 行被修改
+static inline void console_mark(size_t row) {
+    if (row < console_dirty_first) {
+        console_dirty_first = row;
+    }
+    if (row >= console_dirty_last) {
+        console_dirty_last = row + 1;
+    }
+}
+
+// 设置 CRTC 显示起始地址，屏幕从显存的第 row 行开始显示
+static void console_setstart(size_t row) {
+    const uint16_t index = row * VGA_WIDTH;
+    outb(VGA_ADDR, VGA_START_H);
+    outb(VGA_DATA, index >> 8);
+    outb(VGA_ADDR, VGA_START_L);
+    outb(VGA_DATA, index);
+}
+
+// 用 ' ' 填满显存中的第 row 行
+static void console_clearrow(size_t row) {
+    uint16_t *line  = console_buffer + row * VGA_WIDTH;
+    uint16_t  blank = vga_entry(' ', console_color);
+    for (size_t x = 0; x < VGA_WIDTH; x++) {
+        line[x] = blank;
+    }
+    console_mark(row);
+}
+
+// 不是延迟模式时立即写入显存
+static inline void console_sync(void) {
+    if (console_deferred == false) {
+        console_flush();
+    }
+}
+
+// 日志输出到控制台，级别前缀使用对应的颜色
+static void console_klog_write(klog_sink_t *sink __UNUSED__,
+                               const klog_record_t *rec) {
+    uint8_t color = console_color;
+    if (rec->flags & KLOG_PREFIX) {
+        console_color = klog_level_color(rec->level);
+        console_writestring(klog_level_prefix(rec->level));
+    }
+    console_color = rec->color;
+    console_write(rec->text, rec->len);
+    console_color = color;
+}
+
+static klog_sink_t console_klog_sink = {
+    .klog_sink_name  = "console",
+    .klog_sink_level = KLOG_DEBUG,
+    .klog_sink_write = console_klog_write,
+};
 
 void console_init(void) {
     // 从左上角开始
@@ -31,13 +104,18 @@ void console_init(void) {
     // 字体为灰色，背景为黑色
     console_color = vga_entry_color(VGA_COLOR_LIGHT_GREY, VGA_COLOR_BLACK);
     // 用 ' ' 填满屏幕
+    console_top         = 0;
+    console_start       = CONSOLE_MEM_ROWS;
+    console_dirty_first = CONSOLE_MEM_ROWS;
+    console_dirty_last  = 0;
+    console_deferred    = false;
+    console_backend     = NULL;
+    console_cursor      = VGA_CURSOR_INVALID;
     for (size_t y = 0; y < VGA_HEIGHT; y++) {
-        for (size_t x = 0; x < VGA_WIDTH; x++) {
-            const size_t index    = y * VGA_WIDTH + x;
-            console_buffer[index] = vga_entry(' ', console_color);
-        }
+        console_clearrow(y);
     }
-    console_setcursorpos(0, 0);
+    console_flush();
+    klog_register_sink(&console_klog_sink);
 
     printk_info("console_init\n");
     return;
@@ -53,10 +131,11 @@ uint8_t console_getcolor(void) {
     return console_color;
 }
 
-// 在指定位置输出字符
+// 在指定位置输出字符，写入影子缓冲区
 void console_putentryat(char c, uint8_t color, size_t x, size_t y) {
-    const size_t index    = y * VGA_WIDTH + x;
+    const size_t index    = (console_top + y) * VGA_WIDTH + x;
     console_buffer[index] = vga_entry(c, color);
+    console_mark(console_top + y);
 }
 
 // 转义字符处理
@@ -82,8 +161,8 @@ void console_escapeconv(char c) {
     }
 }
 
-// 在当前位置输出字符
-void console_putchar(char c) {
+// 在当前位置输出字符，不更新光标
+static void console_putc(char c) {
     console_putentryat(c, console_color, console_column, console_row);
     // 如果到达最后一列则换行
     if (++console_column >= VGA_WIDTH) {
@@ -94,13 +173,90 @@ void console_putchar(char c) {
     console_escapeconv(c);
     // 屏幕滚动
     console_scroll();
-    console_setcursorpos(console_column, console_row);
 }
 
-// 命令行写
+// 在当前位置输出字符
+void console_putchar(char c) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    console_putc(c);
+    console_sync();
+    local_intr_restore(intr_flag);
+}
+
+// 命令行写，每次调用只写一次显存与光标，每次更新光标需要 4 次端口写
 void console_write(const char *data, size_t size) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
     for (size_t i = 0; i < size; i++)
-        console_putchar(data[i]);
+        console_putc(data[i]);
+    console_sync();
+    local_intr_restore(intr_flag);
+}
+
+// 将影子缓冲区中修改过的可见行写入显存，并更新起始地址与光标
+// 滚出屏幕的行不会再显示，不需要写入
+void console_flush(void) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    size_t first = console_dirty_first > console_top ? console_dirty_first
+                                                     : console_top;
+    size_t last  = console_dirty_last < console_top + VGA_HEIGHT
+                       ? console_dirty_last
+                       : console_top + VGA_HEIGHT;
+    if (console_backend != NULL) {
+        // 没有起始地址可以设置，滚动后整个屏幕交给设备重画
+        if (console_start != console_top) {
+            first         = console_top;
+            last          = console_top + VGA_HEIGHT;
+            console_start = console_top;
+        }
+        if (first >= last) {
+            first = console_top;
+            last  = console_top;
+        }
+        console_backend->console_backend_draw(
+            console_buffer + console_top * VGA_WIDTH, first - console_top,
+            last - console_top, console_column, console_row);
+    }
+    else {
+        if (first < last) {
+            memcpy(console_vga + first * VGA_WIDTH,
+                   console_buffer + first * VGA_WIDTH,
+                   (last - first) * VGA_WIDTH * sizeof(uint16_t));
+        }
+        if (console_start != console_top) {
+            console_setstart(console_top);
+            console_start = console_top;
+        }
+        console_setcursorpos(console_column, console_row);
+    }
+    console_dirty_first = CONSOLE_MEM_ROWS;
+    console_dirty_last  = 0;
+    local_intr_restore(intr_flag);
+}
+
+// 设置是否延迟写入显存，关闭时立即写入之前的修改
+bool console_set_deferred(bool deferred) {
+    bool old         = console_deferred;
+    console_deferred = deferred;
+    if (deferred == false) {
+        console_flush();
+    }
+    return old;
+}
+
+void console_set_backend(const console_backend_t *backend) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    console_backend = backend;
+    // 使 console_flush 重画整个屏幕并重新设置起始地址与光标
+    console_dirty_first = console_top;
+    console_dirty_last  = console_top + VGA_HEIGHT;
+    console_start       = CONSOLE_MEM_ROWS;
+    console_cursor      = VGA_CURSOR_INVALID;
+    console_flush();
+    local_intr_restore(intr_flag);
 }
 
 // 命令行写字符串
@@ -110,7 +266,11 @@ void console_writestring(const char *data) {
 
 // 设置光标位置
 void console_setcursorpos(size_t x, size_t y) {
-    const uint16_t index = y * VGA_WIDTH + x;
+    const uint16_t index = (console_top + y) * VGA_WIDTH + x;
+    if (index == console_cursor) {
+        return;
+    }
+    console_cursor = index;
     // 光标的设置，见参考资料
     // 告诉 VGA 我们要设置光标的高字节
     outb(VGA_ADDR, VGA_CURSOR_H);
@@ -124,26 +284,38 @@ void console_setcursorpos(size_t x, size_t y) {
 
 // 获取光标位置
 uint16_t console_getcursorpos() {
+    if (console_backend != NULL) {
+        return console_row * VGA_WIDTH + console_column;
+    }
     outb(VGA_ADDR, VGA_CURSOR_H);
     size_t cursor_pos_h = inb(VGA_DATA);
     outb(VGA_ADDR, VGA_CURSOR_L);
     size_t cursor_pos_l = inb(VGA_DATA);
-    // 返回光标位置
-    return (cursor_pos_h << 8) | cursor_pos_l;
+    // 返回光标在屏幕上的位置
+    return ((cursor_pos_h << 8) | cursor_pos_l) - console_top * VGA_WIDTH;
 }
 
 // 滚动显示
+// 通过 CRTC 起始地址下移一行实现（在 console_flush 中写入），
+// 只有到达显存末尾时才将屏幕内容复制回开头
 void console_scroll() {
-    if (console_row >= VGA_HEIGHT) {
-        // 将所有行的显示数据复制到上一行
-        for (size_t i = 0; i < (VGA_HEIGHT - 1) * VGA_WIDTH; i++)
-            console_buffer[i] = console_buffer[i + VGA_WIDTH];
-        // 最后的一行数据现在填充空格，不显示任何字符
-        for (size_t i = (VGA_HEIGHT - 1) * VGA_WIDTH;
-             i < VGA_HEIGHT * VGA_WIDTH; i++)
-            console_buffer[i] = vga_entry(' ', console_color);
-        // 向上移动了一行，所以 cursor_y 现在是 24
-        console_row = 24;
+    if (console_row < VGA_HEIGHT) {
+        return;
+    }
+    while (console_row >= VGA_HEIGHT) {
+        console_top++;
+        if (console_top + VGA_HEIGHT > CONSOLE_MEM_ROWS) {
+            // 保留的 VGA_HEIGHT - 1 行复制到显存开头
+            memcpy(console_buffer, console_buffer + console_top * VGA_WIDTH,
+                   (VGA_HEIGHT - 1) * VGA_WIDTH * sizeof(uint16_t));
+            console_top = 0;
+            // 屏幕上的内容都需要重新写入显存
+            console_dirty_first = 0;
+            console_dirty_last  = VGA_HEIGHT;
+        }
+        // 新出现的最后一行填充空格
+        console_clearrow(console_top + VGA_HEIGHT - 1);
+        console_row--;
     }
 }
 
@@ -0,0 +1,258 @@
+
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// fbcon.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "multiboot2.h"
+#include "vmalloc.h"
+#include "console.h"
+#include "fbcon.h"
+
+// 字符单元的内容，低 16 位与 VGA 文本模式相同
+#define FBCON_KEY_CURSOR (0x10000)
+#define FBCON_KEY_INVALID (0xFFFFFFFF)
+
+// VGA 文本模式的 16 色
+static const uint8_t fbcon_vga_rgb[16][3] = {
+    {0x00, 0x00, 0x00}, {0x00, 0x00, 0xAA}, {0x00, 0xAA, 0x00},
+    {0x00, 0xAA, 0xAA}, {0xAA, 0x00, 0x00}, {0xAA, 0x00, 0xAA},
+    {0xAA, 0x55, 0x00}, {0xAA, 0xAA, 0xAA}, {0x55, 0x55, 0x55},
+    {0x55, 0x55, 0xFF}, {0x55, 0xFF, 0x55}, {0x55, 0xFF, 0xFF},
+    {0xFF, 0x55, 0x55}, {0xFF, 0x55, 0xFF}, {0xFF, 0xFF, 0x55},
+    {0xFF, 0xFF, 0xFF},
+};
+
+// 转换为帧缓冲区像素格式的 16 色
+static uint32_t fbcon_palette[16];
+// 每像素字节数
+static size_t fbcon_bytespp;
+// 帧缓冲区每行字节数
+static size_t fbcon_pitch;
+// 控制台左上角在帧缓冲区中的地址
+static uint8_t *fbcon_fb;
+// 字体放大倍数
+static size_t fbcon_scale;
+// 字符单元的像素高度
+static size_t fbcon_cell_h;
+// 字符单元一条扫描线的字节数
+static size_t fbcon_glyph_line;
+// 字形缓存，每项为一个字符单元按帧缓冲区格式预先画好的像素
+static uint8_t *fbcon_cache;
+static uint32_t fbcon_cache_key[FBCON_CACHE_SIZE];
+// 一行字符单元的像素，拼好后每条扫描线只写一次帧缓冲区
+static uint8_t *fbcon_row;
+// 屏幕上每个字符单元当前显示的内容
+static uint32_t *fbcon_drawn;
+
+// 将 8 位的颜色分量放到 pos 开始的 size 位
+static uint32_t fbcon_field(uint8_t value, uint8_t pos, uint8_t size) {
+    if (size >= 8) {
+        return ((uint32_t)value << (size - 8)) << pos;
+    }
+    return ((uint32_t)value >> (8 - size)) << pos;
+}
+
+// 字符 ch 第 y 行的点阵
+static uint8_t fbcon_font_line(uint8_t ch, size_t y) {
+    if (ch >= FBCON_FONT_FIRST && ch <= FBCON_FONT_LAST) {
+        return fbcon_font[ch - FBCON_FONT_FIRST][y];
+    }
+    // 控制台会把换行等控制字符写入屏幕，显示为空白
+    if (ch < FBCON_FONT_FIRST) {
+        return 0x00;
+    }
+    // 字体中没有的字符显示为方框
+    if (y == 0 || y == FBCON_FONT_HEIGHT - 2) {
+        return 0x7E;
+    }
+    return y < FBCON_FONT_HEIGHT - 2 ? 0x42 : 0x00;
+}
+
+// 按帧缓冲区格式画出 key 对应的字符单元
+static void fbcon_render(uint8_t *dst, uint32_t key) {
+    uint8_t  ch     = key & 0xFF;
+    uint32_t fg     = fbcon_palette[(key >> 8) & 0x0F];
+    uint32_t bg     = fbcon_palette[(key >> 12) & 0x0F];
+    size_t   cell_w = FBCON_FONT_WIDTH * fbcon_scale;
+    for (size_t y = 0; y < fbcon_cell_h; y++) {
+        uint8_t line = fbcon_font_line(ch, y / (2 * fbcon_scale));
+        // 光标显示为最后两行（放大前）的下划线
+        if ((key & FBCON_KEY_CURSOR) && y >= fbcon_cell_h - 2 * fbcon_scale) {
+            line = 0xFF;
+        }
+        for (size_t x = 0; x < cell_w; x++) {
+            uint32_t color = (line & (0x80 >> (x / fbcon_scale))) ? fg : bg;
+            if (fbcon_bytespp == 4) {
+                ((uint32_t *)dst)[x] = color;
+            }
+            else {
+                ((uint16_t *)dst)[x] = color;
+            }
+        }
+        dst += fbcon_glyph_line;
+    }
+}
+
+// 获取 key 对应的字形，不在缓存中时画出并替换原来的项
+static const uint8_t *fbcon_glyph(uint32_t key) {
+    uint32_t idx   = (key * 2654435761U) >> (32 - FBCON_CACHE_BITS);
+    uint8_t *glyph = fbcon_cache + idx * fbcon_glyph_line * fbcon_cell_h;
+    if (fbcon_cache_key[idx] != key) {
+        fbcon_render(glyph, key);
+        fbcon_cache_key[idx] = key;
+    }
+    return glyph;
+}
+
+// 重画第 y 行中与屏幕上不同的字符单元
+static void fbcon_drawrow(const uint16_t *cells, size_t y, size_t cx,
+                          size_t cy) {
+    uint32_t *drawn = fbcon_drawn + y * VGA_WIDTH;
+    size_t    x0    = VGA_WIDTH;
+    size_t    x1    = 0;
+    for (size_t x = 0; x < VGA_WIDTH; x++) {
+        uint32_t key = cells[y * VGA_WIDTH + x];
+        if (x == cx && y == cy) {
+            key |= FBCON_KEY_CURSOR;
+        }
+        if (drawn[x] != key) {
+            drawn[x] = key;
+            if (x0 == VGA_WIDTH) {
+                x0 = x;
+            }
+            x1 = x + 1;
+        }
+    }
+    if (x0 >= x1) {
+        return;
+    }
+    // 在内存中拼出 [x0, x1) 的像素，字形都来自缓存
+    size_t   row_pitch = VGA_WIDTH * fbcon_glyph_line;
+    uint8_t *row       = fbcon_row + x0 * fbcon_glyph_line;
+    for (size_t x = x0; x < x1; x++) {
+        const uint8_t *glyph = fbcon_glyph(drawn[x]);
+        uint8_t *      dst   = row + (x - x0) * fbcon_glyph_line;
+        for (size_t line = 0; line < fbcon_cell_h; line++) {
+            memcpy(dst + line * row_pitch, glyph + line * fbcon_glyph_line,
+                   fbcon_glyph_line);
+        }
+    }
+    // 每条扫描线一次连续写入
+    uint8_t *fb = fbcon_fb + y * fbcon_cell_h * fbcon_pitch +
+                  x0 * fbcon_glyph_line;
+    size_t len = (x1 - x0) * fbcon_glyph_line;
+    for (size_t line = 0; line < fbcon_cell_h; line++) {
+        memcpy(fb + line * fbcon_pitch, row + line * row_pitch, len);
+    }
+}
+
+// 没有起始地址寄存器，滚动时 first 与 last 覆盖整个屏幕，
+// 只有内容改变的字符单元会被重新写入帧缓冲区，连续的空白区域不需要写
+static void fbcon_draw(const uint16_t *cells, size_t first, size_t last,
+                       size_t cx, size_t cy) {
+    static size_t cursor_y = 0;
+    // 光标移动后原来所在的行需要擦除光标
+    if (cursor_y != cy && (cursor_y < first || cursor_y >= last)) {
+        fbcon_drawrow(cells, cursor_y, cx, cy);
+    }
+    if (cy < first || cy >= last) {
+        fbcon_drawrow(cells, cy, cx, cy);
+    }
+    for (size_t y = first; y < last; y++) {
+        fbcon_drawrow(cells, y, cx, cy);
+    }
+    cursor_y = cy;
+}
+
+static const console_backend_t fbcon_backend = {
+    .console_backend_draw = fbcon_draw,
+};
+
+// 不能使用帧缓冲区时只是继续使用 VGA 文本模式，不是错误
+bool fbcon_init(void) {
+    struct multiboot_tag_framebuffer *tag = multiboot2_framebuffer;
+    if (tag == NULL ||
+        tag->common.framebuffer_type != MULTIBOOT_FRAMEBUFFER_TYPE_RGB) {
+        return false;
+    }
+    if ((tag->common.framebuffer_bpp != 32 &&
+         tag->common.framebuffer_bpp != 16) ||
+        (tag->common.framebuffer_addr >> 32) != 0) {
+        printk_info("fbcon_init: Unsupported framebuffer, bpp %u.\n",
+                    tag->common.framebuffer_bpp);
+        return false;
+    }
+    size_t width  = tag->common.framebuffer_width;
+    size_t height = tag->common.framebuffer_height;
+    size_t scale_w = width / (VGA_WIDTH * FBCON_FONT_WIDTH);
+    size_t scale_h = height / (VGA_HEIGHT * FBCON_FONT_HEIGHT * 2);
+    fbcon_scale    = scale_w < scale_h ? scale_w : scale_h;
+    if (fbcon_scale == 0) {
+        printk_info("fbcon_init: Framebuffer %ux%u is too small.\n", width,
+                    height);
+        return false;
+    }
+    if (fbcon_scale > FBCON_SCALE_MAX) {
+        fbcon_scale = FBCON_SCALE_MAX;
+    }
+    fbcon_bytespp    = tag->common.framebuffer_bpp / 8;
+    fbcon_pitch      = tag->common.framebuffer_pitch;
+    fbcon_cell_h     = FBCON_FONT_HEIGHT * 2 * fbcon_scale;
+    fbcon_glyph_line = FBCON_FONT_WIDTH * fbcon_scale * fbcon_bytespp;
+    for (size_t i = 0; i < 16; i++) {
+        fbcon_palette[i] =
+            fbcon_field(fbcon_vga_rgb[i][0],
+                        tag->framebuffer_red_field_position,
+                        tag->framebuffer_red_mask_size) |
+            fbcon_field(fbcon_vga_rgb[i][1],
+                        tag->framebuffer_green_field_position,
+                        tag->framebuffer_green_mask_size) |
+            fbcon_field(fbcon_vga_rgb[i][2],
+                        tag->framebuffer_blue_field_position,
+                        tag->framebuffer_blue_mask_size);
+    }
+    uint8_t *fb = ioremap_wc(tag->common.framebuffer_addr,
+                             fbcon_pitch * height);
+    fbcon_cache = vmalloc(FBCON_CACHE_SIZE * fbcon_glyph_line * fbcon_cell_h);
+    fbcon_row   = vmalloc(VGA_WIDTH * fbcon_glyph_line * fbcon_cell_h);
+    fbcon_drawn = vmalloc(VGA_WIDTH * VGA_HEIGHT * sizeof(uint32_t));
+    if (fb == NULL || fbcon_cache == NULL || fbcon_row == NULL ||
+        fbcon_drawn == NULL) {
+        iounmap(fb);
+        vfree(fbcon_cache);
+        vfree(fbcon_row);
+        vfree(fbcon_drawn);
+        printk_info("fbcon_init: No enough virtual memory.\n");
+        return false;
+    }
+    for (size_t i = 0; i < FBCON_CACHE_SIZE; i++) {
+        fbcon_cache_key[i] = FBCON_KEY_INVALID;
+    }
+    for (size_t i = 0; i < VGA_WIDTH * VGA_HEIGHT; i++) {
+        fbcon_drawn[i] = FBCON_KEY_INVALID;
+    }
+    // 黑色在任何像素格式下都为 0，控制台居中显示
+    for (size_t y = 0; y < height; y++) {
+        bzero(fb + y * fbcon_pitch, width * fbcon_bytespp);
+    }
+    fbcon_fb = fb +
+               (height - VGA_HEIGHT * fbcon_cell_h) / 2 * fbcon_pitch +
+               (width - VGA_WIDTH * FBCON_FONT_WIDTH * fbcon_scale) / 2 *
+                   fbcon_bytespp;
+    // 之前的输出都保存在控制台的缓冲区中，切换后全部画出
+    console_set_backend(&fbcon_backend);
+    printk_info("fbcon_init: %ux%ux%u\n", width, height,
+                tag->common.framebuffer_bpp);
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,6 +12,7 @@ extern "C" {
 #endif
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "vga.hpp"
 
 void     console_init(void);
@@ -25,6 +26,22 @@ void     console_escapeconv(char);
 void     console_putentryat(char, uint8_t, size_t, size_t);
 void     console_setcolor(uint8_t);
 uint8_t  console_getcolor(void);
+// 将输出写入显存
+void console_flush(void);
+// 为 true 时输出只写入内存中的缓冲区，由时钟中断调用 console_flush 写入显存
+// 为 false 时每次输出后立即写入，panic 时使用。返回原来的设置
+bool console_set_deferred(bool deferred);
+
+// 控制台的显示设备，没有设置时使用 VGA 文本模式
+typedef struct console_backend {
+    // 显示屏幕上的 [first, last) 行，cells 指向屏幕第一行，格式与 VGA
+    // 文本模式相同，光标位于 (x, y)。first == last 时只更新光标
+    void (*console_backend_draw)(const uint16_t *cells, size_t first,
+                                 size_t last, size_t x, size_t y);
+} console_backend_t;
+
+// 切换显示设备并重画整个屏幕，backend 为 NULL 时恢复 VGA 文本模式
+void console_set_backend(const console_backend_t *backend);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,40 @@
+
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// fbcon.h for Simple-XX/SimpleKernel.
+
+#ifndef _FBCON_H_
+#define _FBCON_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// 字体大小，显示时纵向放大一倍，与 VGA 文本模式的 8x16 相同
+#define FBCON_FONT_WIDTH (8)
+#define FBCON_FONT_HEIGHT (8)
+// 字体包含的字符范围
+#define FBCON_FONT_FIRST (0x20)
+#define FBCON_FONT_LAST (0x7E)
+// 分辨率足够时整数倍放大字符，最大倍数
+#define FBCON_SCALE_MAX (4)
+// 字形缓存的项数为 2^FBCON_CACHE_BITS
+#define FBCON_CACHE_BITS (8)
+#define FBCON_CACHE_SIZE (1 << FBCON_CACHE_BITS)
+
+extern const uint8_t fbcon_font[FBCON_FONT_LAST - FBCON_FONT_FIRST + 1]
+                               [FBCON_FONT_HEIGHT];
+
+// 使用 multiboot2 提供的帧缓冲区显示控制台，支持 16 位与 32 位色
+// 需要在 vmalloc_init 之后调用，没有可用的帧缓冲区时返回 false
+bool fbcon_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FBCON_H_ */
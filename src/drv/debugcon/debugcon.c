@@ -0,0 +1,50 @@
+
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// debugcon.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "port.hpp"
+#include "klog.h"
+#include "debugcon.h"
+
+// 每个字节一次端口写，没有光标与滚动的开销
+static void debugcon_write(const char *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        outb(DEBUGCON_PORT, data[i]);
+    }
+}
+
+static void debugcon_klog_write(klog_sink_t *sink __UNUSED__,
+                                const klog_record_t *rec) {
+    if (rec->flags & KLOG_PREFIX) {
+        const char *prefix = klog_level_prefix(rec->level);
+        debugcon_write(prefix, strlen(prefix));
+    }
+    debugcon_write(rec->text, rec->len);
+}
+
+static klog_sink_t debugcon_klog_sink = {
+    .klog_sink_name  = "debugcon",
+    .klog_sink_level = KLOG_DEBUG,
+    .klog_sink_write = debugcon_klog_write,
+};
+
+bool debugcon_init(void) {
+    if (inb(DEBUGCON_PORT) != DEBUGCON_PORT) {
+        return false;
+    }
+    klog_register_sink(&debugcon_klog_sink);
+    printk_info("debugcon_init\n");
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
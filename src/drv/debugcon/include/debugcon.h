@@ -0,0 +1,29 @@
+
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// debugcon.h for Simple-XX/SimpleKernel.
+
+#ifndef _DEBUGCON_H_
+#define _DEBUGCON_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Bochs/QEMU 的调试端口，写入的字节直接输出到模拟器的控制台或文件
+// QEMU 需要 -debugcon file:debug.log 或 -debugcon stdio
+#define DEBUGCON_PORT (0xE9)
+
+// 检测调试端口，存在时注册为日志输出设备，名称为 debugcon
+// 读取该端口在模拟器中返回 0xE9，在真实硬件上通常不是
+bool debugcon_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DEBUGCON_H_ */
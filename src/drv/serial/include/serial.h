@@ -0,0 +1,82 @@
+
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// serial.h for Simple-XX/SimpleKernel.
+
+#ifndef _SERIAL_H_
+#define _SERIAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+#include "intr.h"
+
+// COM1，使用 IRQ4
+#define SERIAL_COM1 (0x3F8)
+#define SERIAL_IRQ (IRQ4)
+
+// 16550 寄存器，相对于基地址
+// 发送保持寄存器（写）/接收缓冲寄存器（读），DLAB=1 时为除数低字节
+#define SERIAL_THR (0)
+#define SERIAL_DLL (0)
+// 中断使能寄存器，DLAB=1 时为除数高字节
+#define SERIAL_IER (1)
+#define SERIAL_DLM (1)
+// 中断标识寄存器（读）/FIFO 控制寄存器（写）
+#define SERIAL_IIR (2)
+#define SERIAL_FCR (2)
+// 线路控制寄存器
+#define SERIAL_LCR (3)
+// Modem 控制寄存器
+#define SERIAL_MCR (4)
+// 线路状态寄存器
+#define SERIAL_LSR (5)
+
+// IER: 发送保持寄存器空中断
+#define SERIAL_IER_THRE (0x02)
+// IIR: 没有待处理的中断
+#define SERIAL_IIR_NONE (0x01)
+// FCR: 启用并清空 FIFO，接收触发阈值 14 字节
+#define SERIAL_FCR_ENABLE (0xC7)
+// LCR: 8 位数据，无校验，1 位停止位
+#define SERIAL_LCR_8N1 (0x03)
+// LCR: 访问除数寄存器
+#define SERIAL_LCR_DLAB (0x80)
+// MCR: DTR、RTS 与 OUT2，OUT2 打开后中断才会送到 PIC
+#define SERIAL_MCR_NORMAL (0x0B)
+// MCR: 回环模式，用于检测串口是否存在
+#define SERIAL_MCR_LOOPBACK (0x1E)
+// LSR: 发送保持寄存器（FIFO）为空
+#define SERIAL_LSR_THRE (0x20)
+
+// 波特率 115200
+#define SERIAL_DIVISOR (1)
+// 发送 FIFO 大小
+#define SERIAL_FIFO_SIZE (16)
+// 发送缓冲区大小，必须为 2 的幂
+#define SERIAL_TX_SIZE (4096)
+
+// 初始化 COM1，检测不到串口时之后的输出都被忽略
+void serial_init(void);
+
+// 将 data 放入发送缓冲区后立即返回，由发送中断写入 FIFO
+// 缓冲区满时先以轮询方式发送腾出空间，不丢弃输出
+void serial_write(const char *data, size_t size);
+
+// 为 true 时每次输出都以轮询方式发送完毕才返回，panic 时使用
+// 返回原来的设置
+bool serial_set_polled(bool polled);
+
+// IRQ4 处理函数
+void serial_handler(pt_regs_t *regs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SERIAL_H_ */
@@ -0,0 +1,186 @@
+
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// serial.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "port.hpp"
+#include "sync.hpp"
+#include "klog.h"
+#include "serial.h"
+
+// 是否检测到串口
+static bool serial_present;
+// 是否以轮询方式发送
+static bool serial_polled;
+// 当前写入 IER 的值
+static uint8_t serial_ier;
+// 发送缓冲区，head 与 tail 自由增长，取模后为缓冲区中的位置
+// 写入者只移动 head，发送中断只移动 tail
+static char              serial_tx[SERIAL_TX_SIZE];
+static volatile uint32_t serial_tx_head;
+static volatile uint32_t serial_tx_tail;
+
+static inline void serial_set_ier(uint8_t ier) {
+    if (serial_ier != ier) {
+        serial_ier = ier;
+        outb(SERIAL_COM1 + SERIAL_IER, ier);
+    }
+}
+
+// 从缓冲区取出最多 SERIAL_FIFO_SIZE 字节写入 FIFO，调用前 FIFO 需为空
+static void serial_fill_fifo(void) {
+    uint32_t tail = serial_tx_tail;
+    uint32_t head = serial_tx_head;
+    for (uint32_t n = 0; n < SERIAL_FIFO_SIZE && tail != head; n++, tail++) {
+        outb(SERIAL_COM1 + SERIAL_THR, serial_tx[tail & (SERIAL_TX_SIZE - 1)]);
+    }
+    // 写入 FIFO 后才释放空间
+    __asm__ volatile("" : : : "memory");
+    serial_tx_tail = tail;
+}
+
+// 等待 FIFO 为空后再写入一批
+static void serial_poll_fifo(void) {
+    while ((inb(SERIAL_COM1 + SERIAL_LSR) & SERIAL_LSR_THRE) == 0) {
+        ;
+    }
+    serial_fill_fifo();
+}
+
+// 日志输出到串口，不带颜色
+static void serial_klog_write(klog_sink_t *sink __UNUSED__,
+                              const klog_record_t *rec) {
+    if (rec->flags & KLOG_PREFIX) {
+        const char *prefix = klog_level_prefix(rec->level);
+        serial_write(prefix, strlen(prefix));
+    }
+    serial_write(rec->text, rec->len);
+}
+
+static klog_sink_t serial_klog_sink = {
+    .klog_sink_name  = "serial",
+    .klog_sink_level = KLOG_DEBUG,
+    .klog_sink_write = serial_klog_write,
+};
+
+void serial_init(void) {
+    outb(SERIAL_COM1 + SERIAL_IER, 0x00);
+    // 设置波特率
+    outb(SERIAL_COM1 + SERIAL_LCR, SERIAL_LCR_DLAB);
+    outb(SERIAL_COM1 + SERIAL_DLL, SERIAL_DIVISOR & 0xFF);
+    outb(SERIAL_COM1 + SERIAL_DLM, (SERIAL_DIVISOR >> 8) & 0xFF);
+    outb(SERIAL_COM1 + SERIAL_LCR, SERIAL_LCR_8N1);
+    outb(SERIAL_COM1 + SERIAL_FCR, SERIAL_FCR_ENABLE);
+    // 回环模式下发送的数据会被自己收到，收不到说明没有串口
+    outb(SERIAL_COM1 + SERIAL_MCR, SERIAL_MCR_LOOPBACK);
+    outb(SERIAL_COM1 + SERIAL_THR, 0xAE);
+    if (inb(SERIAL_COM1 + SERIAL_THR) != 0xAE) {
+        serial_present = false;
+        printk_info("serial_init: No serial port\n");
+        return;
+    }
+    outb(SERIAL_COM1 + SERIAL_MCR, SERIAL_MCR_NORMAL);
+    serial_ier     = 0x00;
+    serial_polled  = false;
+    serial_tx_head = 0;
+    serial_tx_tail = 0;
+    register_interrupt_handler(SERIAL_IRQ, &serial_handler);
+    enable_irq(SERIAL_IRQ);
+    serial_present = true;
+    klog_register_sink(&serial_klog_sink);
+    printk_info("serial_init\n");
+    return;
+}
+
+void serial_write(const char *data, size_t size) {
+    if (serial_present == false) {
+        return;
+    }
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    while (size > 0) {
+        uint32_t head = serial_tx_head;
+        uint32_t free = SERIAL_TX_SIZE - (head - serial_tx_tail);
+        // 缓冲区满，发送中断不能在这里运行，直接轮询腾出空间
+        if (free == 0) {
+            serial_poll_fifo();
+            continue;
+        }
+        uint32_t pos = head & (SERIAL_TX_SIZE - 1);
+        uint32_t len = SERIAL_TX_SIZE - pos;
+        if (len > free) {
+            len = free;
+        }
+        if (len > size) {
+            len = size;
+        }
+        memcpy(serial_tx + pos, data, len);
+        // 数据写完后才对发送中断可见
+        __asm__ volatile("" : : : "memory");
+        serial_tx_head = head + len;
+        data += len;
+        size -= len;
+    }
+    if (serial_polled == true) {
+        while (serial_tx_tail != serial_tx_head) {
+            serial_poll_fifo();
+        }
+    }
+    else {
+        // FIFO 为空时先写入一批，之后的由发送中断继续
+        if (inb(SERIAL_COM1 + SERIAL_LSR) & SERIAL_LSR_THRE) {
+            serial_fill_fifo();
+        }
+        if (serial_tx_tail != serial_tx_head) {
+            serial_set_ier(SERIAL_IER_THRE);
+        }
+    }
+    local_intr_restore(intr_flag);
+    return;
+}
+
+bool serial_set_polled(bool polled) {
+    if (serial_present == false) {
+        return polled;
+    }
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    bool old      = serial_polled;
+    serial_polled = polled;
+    if (polled == true) {
+        // 不再使用中断，把缓冲区中剩余的数据发送完
+        serial_set_ier(0x00);
+        while (serial_tx_tail != serial_tx_head) {
+            serial_poll_fifo();
+        }
+    }
+    local_intr_restore(intr_flag);
+    return old;
+}
+
+void serial_handler(pt_regs_t *regs __UNUSED__) {
+    // 读取 IIR 清除发送中断
+    inb(SERIAL_COM1 + SERIAL_IIR);
+    if ((inb(SERIAL_COM1 + SERIAL_LSR) & SERIAL_LSR_THRE) == 0) {
+        return;
+    }
+    // 缓冲区已空时关闭发送中断，否则 FIFO 一空就会再次产生
+    if (serial_tx_tail == serial_tx_head) {
+        serial_set_ier(0x00);
+    }
+    else {
+        serial_fill_fifo();
+    }
+    return;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -42,6 +42,12 @@ enum vga_color {
 #define VGA_CURSOR_H 0xE
 // 光标低位
 #define VGA_CURSOR_L 0xF
+// 显示起始地址高位
+#define VGA_START_H 0xC
+// 显示起始地址低位
+#define VGA_START_L 0xD
+// 不可能的光标位置，用于强制下一次写入
+#define VGA_CURSOR_INVALID 0xFFFF
 // VGA 缓存基址
 #define VGA_MEM_BASE (0xB8000)
 // VGA 缓存大小
@@ -0,0 +1,73 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// binlog.h for Simple-XX/SimpleKernel.
+
+#ifndef _BINLOG_H_
+#define _BINLOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+
+// 二进制日志：记录时只保存格式字符串指针、时间戳与原始参数，
+// 格式化推迟到空闲时由 binlog_flush 完成。
+// 因此格式字符串与 %s 参数必须在输出前一直有效（通常是字符串常量）
+
+// 环形缓冲区大小，必须是 2 的幂
+#define BINLOG_RING_SIZE (64 * 1024)
+
+// 一条记录，紧跟其后的是按调用约定排列的参数
+typedef struct binlog_record {
+    // 记录总长度（字节），含记录头；为 0 表示从此处回绕到缓冲区开头
+    uint32_t len;
+    // 格式字符串
+    const char *fmt;
+    // 记录时的时间戳
+    uint64_t tsc;
+    // 参数，每个参数按 4 字节对齐
+    uint32_t args[];
+} binlog_record_t;
+
+// 参数按默认参数提升后在栈上占用的字节数
+#define BINLOG_ARG_SIZE(a) ((sizeof((a) + 0) + 3) & ~3U)
+#define BINLOG_SIZE_0() (0)
+#define BINLOG_SIZE_1(a) BINLOG_ARG_SIZE(a)
+#define BINLOG_SIZE_2(a, ...) (BINLOG_ARG_SIZE(a) + BINLOG_SIZE_1(__VA_ARGS__))
+#define BINLOG_SIZE_3(a, ...) (BINLOG_ARG_SIZE(a) + BINLOG_SIZE_2(__VA_ARGS__))
+#define BINLOG_SIZE_4(a, ...) (BINLOG_ARG_SIZE(a) + BINLOG_SIZE_3(__VA_ARGS__))
+#define BINLOG_SIZE_5(a, ...) (BINLOG_ARG_SIZE(a) + BINLOG_SIZE_4(__VA_ARGS__))
+#define BINLOG_SIZE_6(a, ...) (BINLOG_ARG_SIZE(a) + BINLOG_SIZE_5(__VA_ARGS__))
+#define BINLOG_SIZE_7(a, ...) (BINLOG_ARG_SIZE(a) + BINLOG_SIZE_6(__VA_ARGS__))
+#define BINLOG_SIZE_8(a, ...) (BINLOG_ARG_SIZE(a) + BINLOG_SIZE_7(__VA_ARGS__))
+#define BINLOG_COUNT_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define BINLOG_COUNT(...)                                                      \
+    BINLOG_COUNT_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define BINLOG_CAT_(a, b) a##b
+#define BINLOG_CAT(a, b) BINLOG_CAT_(a, b)
+#define BINLOG_SIZE(...)                                                       \
+    BINLOG_CAT(BINLOG_SIZE_, BINLOG_COUNT(__VA_ARGS__))(__VA_ARGS__)
+
+// 用法与 printk 相同，最多 8 个参数，参数大小在编译时算出
+#define binlog(fmt, ...)                                                       \
+    binlog_write(fmt, BINLOG_SIZE(__VA_ARGS__), ##__VA_ARGS__)
+
+// 写入一条记录，size 为参数的总字节数
+// 缓冲区满时丢弃该记录
+void binlog_write(const char *fmt, uint32_t size, ...);
+
+// 格式化并输出所有记录，返回输出的记录数
+uint32_t binlog_flush(void);
+
+// 因缓冲区满而丢弃的记录数
+uint32_t binlog_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BINLOG_H_ */
@@ -16,6 +16,8 @@ extern "C" {
 void debug_init(ptr_t magic, ptr_t addr);
 void print_cur_status(void);
 void panic(const char *msg);
+// 致命错误时调用，之后日志、控制台与串口都同步输出，不再依赖中断
+void debug_emergency(void);
 void print_stack(size_t count);
 
 #ifdef __cplusplus
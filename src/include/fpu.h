@@ -0,0 +1,51 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// fpu.h for Simple-XX/SimpleKernel.
+
+#ifndef _FPU_H_
+#define _FPU_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+#include "string.h"
+
+// FXSAVE 保存区大小
+#define FPU_STATE_SIZE (512)
+// 不小于该长度的 memcpy/memset/memcmp 使用 SSE2
+#define FPU_SIMD_THRESHOLD (512)
+// 不小于该长度的 memcpy/memset 使用非临时存储，不污染缓存
+#define FPU_NT_THRESHOLD (256 * 1024)
+
+// FXSAVE 保存区，需 16 字节对齐
+typedef struct fpu_state {
+    uint8_t data[FPU_STATE_SIZE];
+} __attribute__((aligned(16))) fpu_state_t;
+
+// SSE2 实现的 memcpy/memset/memcmp
+extern const string_simd_t fpu_simd_string;
+
+// 检查 CPU 特性，开启 SSE 并为 libc 设置 SSE2 实现
+void fpu_init(void);
+
+// CPU 是否支持 SSE2
+bool fpu_available(void);
+
+// 开始在内核中使用 SSE 寄存器，保存当前 FPU/SSE 状态
+// 不支持 SSE2 或当前 CPU 已在使用时返回 false，此时不能使用 SSE 寄存器
+// 返回 true 时需调用 kernel_fpu_end
+bool kernel_fpu_begin(void);
+
+// 结束使用 SSE 寄存器，恢复保存的状态
+void kernel_fpu_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FPU_H_ */
@@ -0,0 +1,115 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// klog.h for Simple-XX/SimpleKernel.
+
+#ifndef _KLOG_H_
+#define _KLOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+#include "stdarg.h"
+#include "stdio.h"
+
+// 内核日志：printk 将格式化后的文本写入环形缓冲区，
+// 再由 klog_flush 交给注册的输出设备（控制台、串口等）。
+// 写入者之间通过 CAS 预留空间，不需要加锁，也不等待输出设备
+
+// 环形缓冲区大小，必须是 2 的幂
+#define KLOG_RING_SIZE (64 * 1024)
+// 单条记录文本的最大长度，超出部分被截断
+#define KLOG_TEXT_MAX (256)
+
+// 记录标志：输出时在文本前加上级别前缀，如 "[INFO] "
+#define KLOG_PREFIX (0x01)
+
+// 一条记录，紧跟其后的是文本，整条记录按 8 字节对齐
+typedef struct klog_record {
+    // 记录总长度（字节），含记录头；写完整条记录后才设置，为 0 表示尚未提交
+    volatile uint16_t size;
+    // 文本长度，为 KLOG_PAD 表示从此处回绕到缓冲区开头
+    uint16_t len;
+    // 序号，每条记录加一，不连续说明有记录丢失
+    uint32_t seq;
+    // 写入时的时间戳
+    uint64_t tsc;
+    // 日志级别
+    uint8_t level;
+    // 写入时的 CPU
+    uint8_t cpu;
+    // 记录标志
+    uint8_t flags;
+    // 控制台颜色
+    uint8_t color;
+    // 文本，不以 '\0' 结尾
+    char text[];
+} klog_record_t;
+
+#define KLOG_PAD (0xFFFF)
+
+// 日志的输出设备
+typedef struct klog_sink {
+    // 名称，用于内核命令行选项 klog.<名称>=<级别>
+    const char *klog_sink_name;
+    // 只输出级别不超过该值的记录，为 KLOG_OFF 时不输出
+    int8_t klog_sink_level;
+    // 输出一条记录
+    void (*klog_sink_write)(struct klog_sink *sink, const klog_record_t *rec);
+    // 下一个输出设备
+    struct klog_sink *next;
+} klog_sink_t;
+
+// 格式化并写入一条记录，返回完整输出所需的字符数
+// 缓冲区满时丢弃该记录；没有输出设备需要该级别时不格式化，返回 0
+int32_t klog_vwrite(uint8_t level, uint8_t flags, uint8_t color,
+                    const char *fmt, va_list args);
+
+// 将已提交的记录交给所有输出设备，返回输出的记录数
+// 同一时间只有一个调用者会输出，其它调用者直接返回 0
+uint32_t klog_flush(void);
+
+// 为 true 时写入后立即返回，由空闲循环调用 klog_flush 输出
+// 为 false 时每次写入后立即输出，启动阶段使用。返回原来的设置
+bool klog_set_deferred(bool deferred);
+
+// panic 与 CPU 异常时调用，之后不再恢复：取得输出权并输出缓冲区中已提交的
+// 记录，之后的记录不进入缓冲区，直接交给输出设备。被打断的 klog_flush 或
+// 写入者不会再继续，它们未完成的记录不会被输出
+void klog_emergency(void);
+
+// 注册与注销输出设备，注册时按内核命令行设置级别
+void klog_register_sink(klog_sink_t *sink);
+void klog_unregister_sink(klog_sink_t *sink);
+
+// 设置输出设备的级别
+void klog_sink_set_level(klog_sink_t *sink, int8_t level);
+
+// 解析内核命令行后调用，按 klog.<名称>=<级别> 重新设置已注册的输出设备，
+// 级别为 err、info、test、debug 或 off。例如 klog.console=err 使屏幕
+// 只显示错误，其余日志只输出到串口或调试端口。
+// 同时按 log.<子系统>=<级别> 设置各子系统的级别，子系统为 kernel、mm、
+// arch、drv 或 test，例如 log.mm=err 去掉 pmm_init 的输出
+void klog_init(void);
+
+// 设置子系统 sys 输出的最高级别，KLOG_OFF 时不输出
+// printk_err 不受影响
+void klog_sys_set_level(uint32_t sys, int8_t level);
+
+// 因缓冲区满而丢弃的记录数
+uint32_t klog_dropped(void);
+
+// 级别前缀，如 "[INFO] "
+const char *klog_level_prefix(uint8_t level);
+// 级别前缀在控制台上的颜色
+uint8_t klog_level_color(uint8_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KLOG_H_ */
@@ -0,0 +1,87 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// arena.h for Simple-XX/SimpleKernel.
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+#include "pmm.h"
+
+// 分配的对齐
+#define ARENA_ALIGN (8)
+
+// arena 中的一块内存，由若干物理页组成，头部位于起始位置
+typedef struct arena_block {
+    // 上一块
+    struct arena_block *prev;
+    // 页数
+    uint32_t pages;
+    // 保持数据 8 字节对齐
+    uint32_t reserved;
+} arena_block_t;
+
+// 单次分配的最大字节数，更大的请求在对齐或计算页数时会溢出
+#define ARENA_SIZE_MAX                                                         \
+    ((size_t)-1 - ARENA_ALIGN - sizeof(arena_block_t) - PMM_PAGE_SIZE)
+
+// 生命周期相同的一组分配，只能整体释放
+typedef struct arena {
+    // 当前块
+    arena_block_t *block;
+    // 当前块中的下一个空闲地址
+    ptr_t cur;
+    // 当前块的结束地址
+    ptr_t end;
+} arena_t;
+
+// arena 中的位置，用于回退
+typedef struct arena_mark {
+    arena_block_t *block;
+    ptr_t          cur;
+} arena_mark_t;
+
+// 初始化一个空的 arena，第一次分配时才申请内存
+void arena_init(arena_t *arena);
+
+// 当前块空间不足时分配新块
+void *arena_alloc_slow(arena_t *arena, size_t size);
+
+// 从 arena 中分配 size 字节，失败时返回 NULL
+static inline void *arena_alloc(arena_t *arena, size_t size) {
+    if (size > ARENA_SIZE_MAX) {
+        return NULL;
+    }
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (size <= arena->end - arena->cur) {
+        void *ptr = (void *)arena->cur;
+        arena->cur += size;
+        return ptr;
+    }
+    return arena_alloc_slow(arena, size);
+}
+
+// 记录当前位置
+static inline arena_mark_t arena_mark(arena_t *arena) {
+    arena_mark_t mark = {arena->block, arena->cur};
+    return mark;
+}
+
+// 回退到 mark，释放其后的所有分配
+void arena_reset(arena_t *arena, arena_mark_t mark);
+
+// 释放 arena 中的所有内存
+void arena_destroy(arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ARENA_H_ */
@@ -43,6 +43,8 @@ typedef struct firstfit_manage {
     uint32_t phy_page_now_count;
     // 空闲链表的节点数量
     uint32_t node_num;
+    // 合并后被删除、可以重用的节点
+    struct list_entry *node_free;
     // 空闲链表
     list_entry_t *free_list;
 } firstfit_manage_t;
@@ -0,0 +1,43 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// highmem.h for Simple-XX/SimpleKernel.
+
+#ifndef _HIGHMEM_H_
+#define _HIGHMEM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "vmm.h"
+
+// 物理地址是否位于 HIGHMEM，HIGHMEM 没有直接映射
+#define PMM_IS_HIGHMEM(pa) ((ptr_t)(pa) >= HIGHMEM_START_ADDR)
+
+// kmap 初始化，预先分配 kmap 区的页表
+void kmap_init(void);
+
+// 将物理地址 pa 所在页映射到持久映射区，返回 pa 对应的虚拟地址
+// 同一物理页多次 kmap 共享一个映射，需要与 kunmap 成对使用
+// 低端内存直接返回直接映射区地址，映射区已满时返回 NULL
+void *kmap(ptr_t pa);
+
+// 释放 kmap 返回的映射
+void kunmap(void *addr);
+
+// 将物理地址 pa 所在页映射到当前 CPU 的固定映射槽，返回 pa 对应的虚拟地址
+// 不需要全局锁，只有一次页表项写入和一次 invlpg
+// 映射按栈的方式使用，必须以相反顺序调用 kunmap_atomic
+void *kmap_atomic(ptr_t pa);
+
+// 释放 kmap_atomic 返回的映射
+void kunmap_atomic(void *addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HIGHMEM_H_ */
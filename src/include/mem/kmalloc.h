@@ -0,0 +1,84 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// kmalloc.h for Simple-XX/SimpleKernel.
+
+#ifndef _KMALLOC_H_
+#define _KMALLOC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+
+// 分配标志
+// 默认
+#define KMALLOC_NORMAL (0x00)
+// 分配的内存清零
+#define KMALLOC_ZERO (0x01)
+
+// 最小的大小类别
+#define KMALLOC_MIN_SIZE (8)
+// 最大的大小类别，超过后直接从 pmm 分配页
+#define KMALLOC_MAX_SIZE (2048)
+// 大小类别的数量，8, 16, ..., 2048
+#define KMALLOC_CACHES (9)
+// 大块内存头部的魔数
+#define KMALLOC_LARGE_MAGIC (0x4B4D4C47UL)
+
+// 大块内存的头部，位于所分配页的起始位置
+typedef struct kmalloc_large {
+    // KMALLOC_LARGE_MAGIC
+    uint32_t magic;
+    // 占用的页数
+    uint32_t pages;
+    // 保持返回地址 16 字节对齐
+    uint32_t reserved[2];
+} kmalloc_large_t;
+
+// 堆管理结构体，普通模式与调试模式分别实现
+typedef struct heap_manage {
+    // 名称
+    const char *name;
+    // 分配 size 字节
+    void *(*heap_manage_alloc)(size_t size, uint32_t flags);
+    // 释放
+    void (*heap_manage_free)(void *ptr);
+    // 实际可用的字节数
+    size_t (*heap_manage_size)(const void *ptr);
+} heap_manage_t;
+
+// 普通模式
+extern const heap_manage_t kmalloc_normal_manage;
+// 调试模式，对象前后有保护区，释放后填充毒值
+extern const heap_manage_t kmalloc_debug_manage;
+
+// kmalloc 初始化，需在 slab_init 之后调用
+// 命令行中有 kmalloc_debug 时使用调试模式
+void kmalloc_init(void);
+
+// 切换堆管理器，调用时不能有未释放的 kmalloc 内存
+void kmalloc_set_manage(const heap_manage_t *manage);
+
+// 调试模式发现的错误数量
+uint32_t kmalloc_debug_errors(void);
+
+// 分配 size 字节内存
+void *kmalloc(size_t size, uint32_t flags);
+
+// 释放 kmalloc 分配的内存
+void kfree(void *ptr);
+
+// ptr 实际可用的字节数
+size_t ksize(const void *ptr);
+
+// 将 ptr 调整为 size 字节，容量足够时原地返回
+void *krealloc(void *ptr, size_t size, uint32_t flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KMALLOC_H_ */
@@ -0,0 +1,105 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// memprof.h for Simple-XX/SimpleKernel.
+
+#ifndef _MEMPROF_H_
+#define _MEMPROF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+
+// 最多记录的未释放分配数量
+#define MEMPROF_RECORDS_MAX (4096)
+// 地址哈希表大小
+#define MEMPROF_HASH_SIZE (1024)
+// 最多统计的调用点数量
+#define MEMPROF_SITES_MAX (256)
+// 调用点哈希表大小，开放寻址，必须是 2 的幂且大于 MEMPROF_SITES_MAX
+#define MEMPROF_SITE_HASH_SIZE (512)
+
+// 分配类型
+// kmalloc
+#define MEMPROF_HEAP (0)
+// pmm 物理页
+#define MEMPROF_PAGE (1)
+
+// 一次未释放的分配
+typedef struct memprof_record {
+    // 分配到的地址
+    ptr_t addr;
+    // 字节数
+    uint32_t size;
+    // 调用者地址
+    ptr_t caller;
+    // 分配类型
+    uint32_t type;
+    // 分配时的时间戳
+    uint64_t tsc;
+    // 哈希链表中的下一项
+    struct memprof_record *next;
+} memprof_record_t;
+
+// 一个调用点的统计
+typedef struct memprof_site {
+    // 调用者地址
+    ptr_t caller;
+    // 分配类型
+    uint32_t type;
+    // 累计分配次数
+    uint32_t allocs;
+    // 累计分配字节数
+    uint32_t total_bytes;
+    // 未释放的次数
+    uint32_t live;
+    // 未释放的字节数
+    uint32_t live_bytes;
+} memprof_site_t;
+
+// 是否开启，关闭时每次分配只有一次判断
+extern bool memprof_enabled;
+
+// 初始化，命令行中有 memprof 时开启
+void memprof_init(void);
+
+// 开启或关闭，关闭后已有的记录保留
+void memprof_enable(bool enable);
+
+// 记录一次分配
+void memprof_record_alloc(uint32_t type, ptr_t addr, uint32_t size,
+                          ptr_t caller);
+
+// 记录一次释放
+void memprof_record_free(uint32_t type, ptr_t addr);
+
+static inline void memprof_alloc(uint32_t type, ptr_t addr, uint32_t size,
+                                 ptr_t caller) {
+    if (memprof_enabled == true) {
+        memprof_record_alloc(type, addr, size, caller);
+    }
+    return;
+}
+
+static inline void memprof_free(uint32_t type, ptr_t addr) {
+    if (memprof_enabled == true) {
+        memprof_record_free(type, addr);
+    }
+    return;
+}
+
+// 输出各调用点的统计
+void memprof_dump(void);
+
+// 标记-扫描，输出没有被引用的 kmalloc 内存，返回其数量
+uint32_t memprof_leak_check(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MEMPROF_H_ */
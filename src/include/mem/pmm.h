@@ -153,6 +153,9 @@ typedef struct pmm_manage {
     void (*pmm_manage_free)(ptr_t addr_start, uint32_t bytes, int8_t zone);
     // 返回当前可用内存页数量
     uint32_t (*pmm_manage_free_pages_count)(int8_t zone);
+    // 申请按 align 个页对齐的 pages 个物理页
+    ptr_t (*pmm_manage_alloc_align)(uint32_t pages, uint32_t align,
+                                    int8_t zone);
 } pmm_manage_t;
 
 // 从 GRUB 读取物理内存信息
@@ -173,6 +176,10 @@ ptr_t pmm_alloc(size_t byte, int8_t zone);
 // 请求 zone 区域的指定数量物理页
 ptr_t pmm_alloc_page(uint32_t pages, int8_t zone);
 
+// 请求 zone 区域的 pages 个物理页，起始地址按 align 个页对齐
+// align 需为 2 的幂
+ptr_t pmm_alloc_page_align(uint32_t pages, uint32_t align, int8_t zone);
+
 // 释放内存
 void pmm_free_page(ptr_t addr, uint32_t byte, int8_t zone);
 
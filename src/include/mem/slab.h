@@ -0,0 +1,114 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// slab.h for Simple-XX/SimpleKernel.
+
+#ifndef _SLAB_H_
+#define _SLAB_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+#include "cpu.hpp"
+
+// slab 头部魔数，用于检查释放的对象是否属于 slab
+#define SLAB_MAGIC (0x51AB51ABUL)
+// 空闲链表结束标记
+#define SLAB_BUFCTL_END (0xFFFF)
+// 对象最小对齐
+#define SLAB_MIN_ALIGN (sizeof(void *))
+// 单个 slab 最多占用的页数
+#define SLAB_MAX_PAGES (8)
+// 每个 CPU 缓存的对象数量上限
+#define SLAB_MAGAZINE_SIZE (16)
+// 每次从 slab 中补充、归还的对象数量
+#define SLAB_MAGAZINE_BATCH (8)
+// 每个 cache 保留的空 slab 数量，超过后归还 pmm
+#define SLAB_EMPTY_MAX (2)
+
+// slab 头部，位于 slab 的起始位置
+// 其后是 num 个空闲链表下标，然后是对象
+typedef struct slab {
+    // SLAB_MAGIC
+    uint32_t magic;
+    // 所属的 cache
+    struct kmem_cache *cache;
+    // 已分配的对象数量
+    uint32_t inuse;
+    // 第一个空闲对象的下标
+    uint32_t free;
+    // 所在链表中的前后节点
+    struct slab *prev;
+    struct slab *next;
+} slab_t;
+
+// 每个 CPU 的对象缓存，分配与释放时不需要访问 slab
+typedef struct kmem_magazine {
+    // 缓存的对象数量
+    uint32_t avail;
+    // 缓存的对象，按栈使用
+    void *entries[SLAB_MAGAZINE_SIZE];
+} kmem_magazine_t;
+
+typedef struct kmem_cache {
+    // 名称
+    const char *name;
+    // 对齐后的对象大小
+    size_t size;
+    // 对象对齐
+    size_t align;
+    // 每个 slab 的页数
+    uint32_t slab_pages;
+    // 每个 slab 中的对象数量
+    uint32_t num;
+    // 第一个对象相对 slab 起始地址的偏移
+    uint32_t obj_offset;
+    // 对象构造函数，在 slab 创建时对每个对象调用一次
+    // 释放的对象需要恢复到构造后的状态
+    void (*ctor)(void *obj);
+    // 部分使用、全部使用、全部空闲的 slab
+    slab_t *slabs_partial;
+    slab_t *slabs_full;
+    slab_t *slabs_empty;
+    // 空 slab 的数量
+    uint32_t empty_count;
+    // slab 总数
+    uint32_t slab_count;
+    // 每个 CPU 的对象缓存
+    kmem_magazine_t cpu[CPU_MAX];
+    // cache 链表
+    struct kmem_cache *next;
+} kmem_cache_t;
+
+// slab 初始化
+void slab_init(void);
+
+// 创建对象大小为 size 的 cache，align 为 0 时使用默认对齐
+// ctor 可以为 NULL
+kmem_cache_t *kmem_cache_create(const char *name, size_t size, size_t align,
+                                void (*ctor)(void *obj));
+
+// 销毁 cache，所有对象需已释放
+void kmem_cache_destroy(kmem_cache_t *cache);
+
+// 分配一个对象
+void *kmem_cache_alloc(kmem_cache_t *cache);
+
+// 释放一个对象
+void kmem_cache_free(kmem_cache_t *cache, void *obj);
+
+// 归还每个 CPU 缓存中的对象，并释放所有空 slab
+void kmem_cache_shrink(kmem_cache_t *cache);
+
+// 获取对象所在的 slab，对象不属于任何 slab 时返回 NULL
+slab_t *slab_get(const void *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLAB_H_ */
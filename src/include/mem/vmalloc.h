@@ -0,0 +1,92 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// vmalloc.h for Simple-XX/SimpleKernel.
+
+#ifndef _VMALLOC_H_
+#define _VMALLOC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+#include "vmm.h"
+
+// 延迟释放的页数超过该值时统一刷新 TLB，回收虚拟地址
+#define VMALLOC_LAZY_MAX_PAGES (512)
+
+// 区域标志
+// 由 vmalloc 分配的物理页，释放时一并归还
+#define VM_ALLOC (0x01)
+// 已释放，等待刷新 TLB 后回收虚拟地址
+#define VM_LAZY_FREE (0x02)
+// 允许在空闲时合并为 4MB 大页
+#define VM_HUGE (0x04)
+
+// vmalloc 区中的一段虚拟地址
+typedef struct vm_area {
+    // 起始地址
+    ptr_t addr;
+    // 大小，包含末尾的一个保护页
+    size_t size;
+    // 区域标志
+    uint32_t flags;
+    // 按地址排序的下一个区域
+    struct vm_area *next;
+} vm_area_t;
+
+// vmalloc 统计信息
+typedef struct vmalloc_stat {
+    // 尝试合并的次数
+    uint32_t collapse_scan;
+    // 合并成功的次数
+    uint32_t collapse_success;
+    // 因没有对齐的物理内存而失败的次数
+    uint32_t collapse_fail;
+    // 当前使用的大页数量
+    uint32_t large_pages;
+} vmalloc_stat_t;
+
+// vmalloc 初始化
+void vmalloc_init(void);
+
+// 分配 size 字节虚拟地址连续的内存，物理页可以不连续
+void *vmalloc(size_t size);
+
+// 与 vmalloc 相同，但起始地址按 4MB 对齐，并允许合并为大页
+void *vmalloc_huge(size_t size);
+
+// 设置 addr 所在区域是否允许合并为大页，只接受 vmalloc 分配的区域
+bool vmalloc_set_huge(void *addr, bool enable);
+
+// 将一个已全部映射、4MB 对齐的区间合并为大页，在空闲时调用
+// 每次调用最多合并一个大页，没有可合并的区间时返回 false
+// 没有对齐的物理内存时清除该区域的 VM_HUGE，之后不再尝试
+bool vmalloc_collapse(void);
+
+// 获取统计信息
+void vmalloc_get_stat(vmalloc_stat_t *stat);
+
+// 释放 vmalloc 分配的内存，TLB 刷新被推迟到 vmalloc_purge()
+void vfree(void *addr);
+
+// 刷新所有延迟释放区域的 TLB，并回收其虚拟地址
+void vmalloc_purge(void);
+
+// 将物理地址 pa 开始的 size 字节设备内存映射到 vmalloc 区，不使用缓存
+void *ioremap(ptr_t pa, size_t size);
+
+// 与 ioremap 相同，但允许 MTRR 将其设置为写合并，用于帧缓冲区
+void *ioremap_wc(ptr_t pa, size_t size);
+
+// 解除 ioremap 的映射，不释放物理页
+void iounmap(void *addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _VMALLOC_H_ */
@@ -0,0 +1,167 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// vmm.h for Simple-XX/SimpleKernel.
+
+#ifndef _VMM_H_
+#define _VMM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+#include "cpu.hpp"
+#include "pmm.h"
+
+// 页目录项、页表项，32 位非 PAE 模式下均为 4 字节
+typedef uint32_t pgd_t;
+typedef uint32_t pte_t;
+
+// 页大小 4KB
+#define VMM_PAGE_SIZE (0x1000UL)
+// 页掩码，用于 4KB 对齐
+#define VMM_PAGE_MASK (0xFFFFF000UL)
+// 大页大小 4MB，需要 CR4.PSE
+#define VMM_LARGE_PAGE_SIZE (0x400000UL)
+// 大页掩码，用于 4MB 对齐
+#define VMM_LARGE_PAGE_MASK (0xFFC00000UL)
+// 每个页目录/页表的项数
+#define VMM_ENTRIES_PER_TABLE (1024)
+
+// 虚拟地址在页目录中的下标
+#define VMM_PGD_INDEX(va) (((ptr_t)(va) >> 22) & 0x3FF)
+// 虚拟地址在页表中的下标
+#define VMM_PTE_INDEX(va) (((ptr_t)(va) >> 12) & 0x3FF)
+// 按页向上对齐
+#define VMM_PAGE_ALIGN(x) (((ptr_t)(x) + VMM_PAGE_SIZE - 1) & VMM_PAGE_MASK)
+
+// 页目录项、页表项的标志位
+// 存在
+#define VMM_PAGE_PRESENT (0x00000001)
+// 可写
+#define VMM_PAGE_RW (0x00000002)
+// 用户态可访问
+#define VMM_PAGE_USER (0x00000004)
+// 写透
+#define VMM_PAGE_PWT (0x00000008)
+// 禁止缓存
+#define VMM_PAGE_PCD (0x00000010)
+// 已访问
+#define VMM_PAGE_ACCESSED (0x00000020)
+// 已写入
+#define VMM_PAGE_DIRTY (0x00000040)
+// 页目录项指向 4MB 大页
+#define VMM_PAGE_LARGE (0x00000080)
+// 全局页，重新加载 CR3 时不会被刷新，需要 CR4.PGE
+#define VMM_PAGE_GLOBAL (0x00000100)
+// 内核页默认属性
+#define VMM_PAGE_KERNEL (VMM_PAGE_PRESENT | VMM_PAGE_RW)
+
+/*
+ 内核虚拟地址空间布局
+ 0x00000000 ~ VMM_DIRECT_MAP_END    直接映射区，虚拟地址 == 物理地址
+ VMM_VMALLOC_START ~ VMM_VMALLOC_END vmalloc 区，映射不连续的物理页
+ VMM_PKMAP_START ~ VMM_PKMAP_END    kmap 持久映射区
+ VMM_FIXMAP_START ~ VMM_FIXMAP_END  kmap_atomic 固定映射区
+ VMM_FIXMAP_END ~ VMM_RECURSIVE_BASE 保留
+ VMM_RECURSIVE_BASE ~ 0xFFFFFFFF    递归映射区，当前地址空间的所有页表
+*/
+// 直接映射区结束地址，HIGHMEM 不做直接映射
+#define VMM_DIRECT_MAP_END (HIGHMEM_START_ADDR)
+// vmalloc 区起始地址，与直接映射区之间留出 8MB 的空洞，用于捕获越界访问
+#define VMM_VMALLOC_START (VMM_DIRECT_MAP_END + 0x800000UL)
+// vmalloc 区结束地址
+#define VMM_VMALLOC_END (0xFF000000UL)
+// kmap 持久映射区，共 VMM_PKMAP_NR 个页
+#define VMM_PKMAP_NR (512)
+#define VMM_PKMAP_START (VMM_VMALLOC_END)
+#define VMM_PKMAP_END (VMM_PKMAP_START + VMM_PKMAP_NR * VMM_PAGE_SIZE)
+// kmap_atomic 固定映射区，每个 CPU 有 VMM_KMAP_ATOMIC_NR 个页
+#define VMM_KMAP_ATOMIC_NR (16)
+#define VMM_FIXMAP_START (VMM_PKMAP_END)
+#define VMM_FIXMAP_END                                                         \
+    (VMM_FIXMAP_START + CPU_MAX * VMM_KMAP_ATOMIC_NR * VMM_PAGE_SIZE)
+
+// 页目录的最后一项指向页目录自身
+#define VMM_RECURSIVE_INDEX (VMM_ENTRIES_PER_TABLE - 1)
+// 递归映射区起始地址，所有页表依次排列在此
+#define VMM_RECURSIVE_BASE (0xFFC00000UL)
+// 页目录自身也被映射为递归映射区的最后一页
+#define VMM_RECURSIVE_PGD ((pgd_t *)0xFFFFF000UL)
+// 当前地址空间中 va 的页表项，对应的页目录项必须存在且不是大页
+#define VMM_RECURSIVE_PTE(va)                                                  \
+    ((pte_t *)VMM_RECURSIVE_BASE + ((ptr_t)(va) >> 12))
+
+// 待刷新的 TLB 项不超过该值时逐页 invlpg，超过则重新加载 CR3
+#define VMM_TLB_BATCH_MAX (32)
+
+// 页表页缓存的低水位，低于该值时 vmm_pgtable_refill() 补充
+#define VMM_PGTABLE_POOL_LOW (16)
+// 页表页缓存的高水位，超过后释放的页表页直接归还 pmm
+#define VMM_PGTABLE_POOL_HIGH (64)
+
+// 内核页目录
+extern pgd_t pgd_kernel[VMM_ENTRIES_PER_TABLE];
+// 当前使用的页目录
+extern pgd_t *pgd_current;
+
+// 初始化虚拟内存管理，建立直接映射并开启分页
+void vmm_init(void);
+
+// 从缓存中分配一个已清零的页表页，缓存为空时从 pmm 分配
+pte_t *vmm_pgtable_alloc(void);
+
+// 释放页表页，清零后放回缓存
+void vmm_pgtable_free(pte_t *pte);
+
+// 将页表页缓存补充到高水位，在空闲时调用，不应在映射路径上调用
+// NORMAL 用完时不补充，下次调用时重新检查
+void vmm_pgtable_refill(void);
+
+// 页表页缓存中的页数
+uint32_t vmm_pgtable_pool_count(void);
+
+// 将虚拟地址 va 映射到物理地址 pa，页表不存在时自动分配
+// 调用者需保证 va 不在 TLB 待刷新队列中
+bool vmm_map(pgd_t *pgd, ptr_t va, ptr_t pa, uint32_t flags);
+
+// 切换到页目录 pgd
+void vmm_switch_pgd(pgd_t *pgd);
+
+// 获取 va 对应的页表项，页表不存在且 create 为 true 时自动分配
+// va 被大页映射或分配失败时返回 NULL
+// pgd 为当前页目录时返回递归映射区中的地址，只在该地址空间中有效
+pte_t *vmm_get_pte(pgd_t *pgd, ptr_t va, bool create);
+
+// 使用一个 4MB 大页将 va 所在的 4MB 映射到 pa，原有的页表会被释放
+// 调用者需自行处理原页表中映射的物理页，不支持 PSE 时返回 false
+bool vmm_map_large(pgd_t *pgd, ptr_t va, ptr_t pa, uint32_t flags);
+
+// 是否支持 4MB 大页
+bool vmm_has_large_page(void);
+
+// 取消 va 的映射，va 会被加入 TLB 待刷新队列，
+// 调用者需在重用 va 前调用 vmm_tlb_flush()
+// va 被大页映射时取消整个大页的映射
+void vmm_unmap(pgd_t *pgd, ptr_t va);
+
+// 修改 va 的页表项属性，物理地址不变，va 未映射时返回 false
+bool vmm_protect(pgd_t *pgd, ptr_t va, uint32_t flags);
+
+// 获取 va 映射到的物理地址，未映射时返回 false
+bool vmm_get_mapping(pgd_t *pgd, ptr_t va, ptr_t *pa);
+
+// 将 va 加入 TLB 待刷新队列
+void vmm_tlb_queue(ptr_t va);
+
+// 刷新 TLB 待刷新队列
+void vmm_tlb_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _VMM_H_ */
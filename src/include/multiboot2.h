@@ -252,6 +252,39 @@ struct multiboot_tag_vbe {
     struct multiboot_vbe_mode_info_block vbe_mode_info;
 };
 
+struct multiboot_tag_framebuffer_common {
+    multiboot_uint32_t type;
+    multiboot_uint32_t size;
+    multiboot_uint64_t framebuffer_addr;
+    multiboot_uint32_t framebuffer_pitch;
+    multiboot_uint32_t framebuffer_width;
+    multiboot_uint32_t framebuffer_height;
+    multiboot_uint8_t  framebuffer_bpp;
+#define MULTIBOOT_FRAMEBUFFER_TYPE_INDEXED 0
+#define MULTIBOOT_FRAMEBUFFER_TYPE_RGB 1
+#define MULTIBOOT_FRAMEBUFFER_TYPE_EGA_TEXT 2
+    multiboot_uint8_t  framebuffer_type;
+    multiboot_uint16_t reserved;
+};
+
+struct multiboot_tag_framebuffer {
+    struct multiboot_tag_framebuffer_common common;
+    union {
+        struct {
+            multiboot_uint16_t     framebuffer_palette_num_colors;
+            struct multiboot_color framebuffer_palette[0];
+        };
+        struct {
+            multiboot_uint8_t framebuffer_red_field_position;
+            multiboot_uint8_t framebuffer_red_mask_size;
+            multiboot_uint8_t framebuffer_green_field_position;
+            multiboot_uint8_t framebuffer_green_mask_size;
+            multiboot_uint8_t framebuffer_blue_field_position;
+            multiboot_uint8_t framebuffer_blue_mask_size;
+        };
+    };
+};
+
 struct multiboot_tag_elf_sections {
     multiboot_uint32_t type; // 0x09
     multiboot_uint32_t size;
@@ -353,8 +386,15 @@ void print_MULTIBOOT_TAG_TYPE_ELF_SECTIONS(struct multiboot_tag *tag);
 void print_MULTIBOOT_TAG_TYPE_APM(struct multiboot_tag *tag);
 void print_MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR(struct multiboot_tag *tag);
 
+// 内核命令行中是否有选项 opt
+bool multiboot2_cmdline_has(const char *opt);
+
 extern multiboot_memory_map_entry_t *mmap_entries;
 extern multiboot_mmap_tag_t *        mmap_tag;
+// 内核命令行，没有时为 NULL
+extern const char *multiboot2_cmdline;
+// 引导程序设置的帧缓冲区，没有时为 NULL
+extern struct multiboot_tag_framebuffer *multiboot2_framebuffer;
 
 #endif /*  ! ASM_FILE */
 
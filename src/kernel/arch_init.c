@@ -12,6 +12,7 @@ extern "C" {
 #include "sync.hpp"
 #include "intr.h"
 #include "gdt.h"
+#include "fpu.h"
 #include "arch_init.h"
 
 void arch_init(void) {
@@ -19,6 +20,8 @@ void arch_init(void) {
     gdt_init();
     // IDT 初始化
     intr_init();
+    // FPU/SSE 初始化
+    fpu_init();
     return;
 }
 
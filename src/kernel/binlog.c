@@ -0,0 +1,92 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// binlog.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "stdarg.h"
+#include "cpu.hpp"
+#include "sync.hpp"
+#include "klog.h"
+#include "binlog.h"
+
+// 环形缓冲区，head 与 tail 自由增长，取模后为缓冲区中的位置
+// 生产者只移动 head，消费者只移动 tail
+static uint8_t           binlog_ring[BINLOG_RING_SIZE] __attribute__((aligned(8)));
+static volatile uint32_t binlog_head;
+static volatile uint32_t binlog_tail;
+static uint32_t          binlog_lost;
+
+void binlog_write(const char *fmt, uint32_t size, ...) {
+    uint32_t len = sizeof(binlog_record_t) + size;
+    bool     intr_flag = false;
+    local_intr_store(intr_flag);
+    uint32_t head = binlog_head;
+    uint32_t pos  = head & (BINLOG_RING_SIZE - 1);
+    // 记录不能跨过缓冲区末尾，剩余部分作为填充跳过
+    uint32_t pad = pos + len > BINLOG_RING_SIZE ? BINLOG_RING_SIZE - pos : 0;
+    if (head + pad + len - binlog_tail > BINLOG_RING_SIZE) {
+        binlog_lost++;
+        local_intr_restore(intr_flag);
+        return;
+    }
+    if (pad != 0) {
+        *(uint32_t *)&binlog_ring[pos] = 0;
+        pos                            = 0;
+    }
+    binlog_record_t *rec = (binlog_record_t *)&binlog_ring[pos];
+    rec->len             = len;
+    rec->fmt             = fmt;
+    rec->tsc             = cpu_rdtsc();
+    // 参数在栈上连续存放，直接按字复制
+    va_list args;
+    va_start(args, size);
+    for (uint32_t i = 0; i < size / sizeof(uint32_t); i++) {
+        rec->args[i] = va_arg(args, uint32_t);
+    }
+    va_end(args);
+    // 记录写完后才对消费者可见
+    __asm__ volatile("" : : : "memory");
+    binlog_head = head + pad + len;
+    local_intr_restore(intr_flag);
+    return;
+}
+
+uint32_t binlog_flush(void) {
+    uint32_t count = 0;
+    uint32_t tail  = binlog_tail;
+    while (tail != binlog_head) {
+        __asm__ volatile("" : : : "memory");
+        uint32_t         pos = tail & (BINLOG_RING_SIZE - 1);
+        binlog_record_t *rec = (binlog_record_t *)&binlog_ring[pos];
+        if (rec->len == 0) {
+            tail += BINLOG_RING_SIZE - pos;
+        }
+        else {
+            // 时间戳与内容作为一条日志写入，不会被其它输出隔开
+            char   buf[KLOG_TEXT_MAX];
+            size_t len = snprintf(buf, sizeof(buf), "[%llu] ", rec->tsc);
+            vsnprintf(buf + len, sizeof(buf) - len, rec->fmt,
+                      (va_list)rec->args);
+            printk("%s", buf);
+            tail += rec->len;
+            count++;
+        }
+        // 输出完成后才释放空间
+        __asm__ volatile("" : : : "memory");
+        binlog_tail = tail;
+    }
+    return count;
+}
+
+uint32_t binlog_dropped(void) {
+    return binlog_lost;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,10 +15,17 @@ extern "C" {
 #include "stdbool.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include "string.h"
 #include "console.h"
 #include "multiboot2.h"
 #include "arch_init.h"
 #include "pmm.h"
+#include "vmm.h"
+#include "vmalloc.h"
+#include "highmem.h"
+#include "slab.h"
+#include "kmalloc.h"
+#include "memprof.h"
 
 void kernel_main(uint32_t magic, uint32_t addr);
 
@@ -12,33 +12,68 @@ extern "C" {
 #include "debug.h"
 #include "assert.h"
 #include "kernel.h"
+#include "binlog.h"
+#include "klog.h"
 #include "clock.h"
 #include "keyboard.h"
+#include "serial.h"
+#include "debugcon.h"
+#include "fbcon.h"
 #include "test.h"
 
 // 内核入口
 void kernel_main(ptr_t magic, ptr_t addr) {
+    // 根据 CPU 特性选择 memcpy/memset 实现
+    string_init(cpu_has_erms());
     // 控制台初始化
     console_init();
+    // 模拟器的调试端口，只需要端口读写
+    debugcon_init();
     // 从 multiboot 获得系统初始信息
     multiboot2_init(magic, addr);
+    // 按内核命令行设置各输出设备的日志级别
+    klog_init();
     // GDT、IDT 初始化
     arch_init();
     // 时钟初始化
     clock_init();
     // 键盘初始化
     keyboard_init();
+    // 串口初始化，之后的输出同时写到 COM1
+    serial_init();
     // 调试模块初始化
     debug_init(magic, addr);
+    // 内存分析初始化
+    memprof_init();
     // 物理内存初始化
     pmm_init();
+    // 虚拟内存初始化
+    vmm_init();
+    kmap_init();
+    // 内核对象分配器初始化
+    slab_init();
+    kmalloc_init();
+    // 非连续内存分配初始化
+    vmalloc_init();
+    // 引导程序设置了图形模式时，控制台改为画在帧缓冲区上
+    fbcon_init();
 
     test();
     showinfo();
 
+    // 之后的日志由空闲循环输出，控制台输出由时钟中断批量写入显存
+    klog_set_deferred(true);
+    console_set_deferred(true);
     cpu_sti();
     while (1) {
-        ;
+        // 空闲时将日志输出到控制台与串口
+        klog_flush();
+        // 空闲时输出二进制日志
+        binlog_flush();
+        // 空闲时补充页表页缓存
+        vmm_pgtable_refill();
+        // 合并 vmalloc 区中的大页
+        vmalloc_collapse();
     }
 
     // 永远不会执行到这里
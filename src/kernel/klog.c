@@ -0,0 +1,349 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// klog.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "cpu.hpp"
+#include "sync.hpp"
+#include "multiboot2.h"
+#include "klog.h"
+
+// 记录按 8 字节对齐
+#define KLOG_ALIGN(x) (((x) + 7) & ~7U)
+
+// 环形缓冲区，head 与 tail 自由增长，取模后为缓冲区中的位置
+// 写入者通过 CAS 移动 head 预留空间，只有 klog_flush 移动 tail
+// 未使用的空间全部为 0，这样预留后尚未提交的记录 size 一定为 0
+static uint8_t           klog_ring[KLOG_RING_SIZE] __attribute__((aligned(8)));
+static volatile uint32_t klog_head;
+static volatile uint32_t klog_tail;
+static volatile uint32_t klog_seq;
+static volatile uint32_t klog_lost;
+// 已经报告过的丢失记录数
+static uint32_t klog_lost_reported;
+// 正在输出时为 1
+static volatile uint32_t klog_busy;
+static bool              klog_deferred;
+// 紧急模式下记录不进入缓冲区，直接交给输出设备
+static volatile bool klog_emergency_mode;
+static klog_sink_t *     klog_sinks;
+// 所有输出设备级别的最大值，更高级别的记录不需要格式化
+static volatile int8_t klog_sinks_level = KLOG_OFF;
+
+uint32_t klog_mask[KLOG_LEVEL_MAX] = {
+    [KLOG_ERR]   = (1U << KLOG_SYS_MAX) - 1,
+    [KLOG_INFO]  = (1U << KLOG_SYS_MAX) - 1,
+    [KLOG_TEST]  = (1U << KLOG_SYS_MAX) - 1,
+    [KLOG_DEBUG] = (1U << KLOG_SYS_MAX) - 1,
+};
+
+// 内核命令行中的子系统名称
+static const char *const klog_sys_name[KLOG_SYS_MAX] = {
+    [KLOG_SYS_KERNEL] = "kernel", [KLOG_SYS_MM] = "mm",
+    [KLOG_SYS_ARCH] = "arch",     [KLOG_SYS_DRV] = "drv",
+    [KLOG_SYS_TEST] = "test",
+};
+
+// 内核命令行中的级别名称
+static const char *const klog_level_name[KLOG_LEVEL_MAX] = {
+    [KLOG_ERR]   = "err",
+    [KLOG_INFO]  = "info",
+    [KLOG_TEST]  = "test",
+    [KLOG_DEBUG] = "debug",
+};
+
+static const char *const klog_prefix[KLOG_LEVEL_MAX] = {
+    [KLOG_ERR]   = "[ERROR] ",
+    [KLOG_INFO]  = "[INFO] ",
+    [KLOG_TEST]  = "[TEST] ",
+    [KLOG_DEBUG] = "[DEBUG] ",
+};
+
+static const uint8_t klog_color[KLOG_LEVEL_MAX] = {
+    [KLOG_ERR]   = COL_ERROR,
+    [KLOG_INFO]  = COL_INFO,
+    [KLOG_TEST]  = COL_TEST,
+    [KLOG_DEBUG] = COL_DEBUG,
+};
+
+const char *klog_level_prefix(uint8_t level) {
+    return level < KLOG_LEVEL_MAX ? klog_prefix[level] : "";
+}
+
+uint8_t klog_level_color(uint8_t level) {
+    return level < KLOG_LEVEL_MAX ? klog_color[level] : COL_INFO;
+}
+
+// 预留 size 字节，空间不足时返回 NULL
+static klog_record_t *klog_reserve(uint32_t size) {
+    uint32_t head;
+    uint32_t pad;
+    do {
+        head         = klog_head;
+        uint32_t pos = head & (KLOG_RING_SIZE - 1);
+        // 记录不能跨过缓冲区末尾，剩余部分作为填充跳过
+        pad = pos + size > KLOG_RING_SIZE ? KLOG_RING_SIZE - pos : 0;
+        if (head + pad + size - klog_tail > KLOG_RING_SIZE) {
+            __sync_fetch_and_add(&klog_lost, 1);
+            return NULL;
+        }
+    } while (__sync_val_compare_and_swap(&klog_head, head,
+                                         head + pad + size) != head);
+    if (pad != 0) {
+        klog_record_t *fill =
+            (klog_record_t *)&klog_ring[head & (KLOG_RING_SIZE - 1)];
+        fill->len = KLOG_PAD;
+        __asm__ volatile("" : : : "memory");
+        fill->size = pad;
+    }
+    return (klog_record_t *)&klog_ring[(head + pad) & (KLOG_RING_SIZE - 1)];
+}
+
+// 交给所有输出设备
+static void klog_deliver(const klog_record_t *rec) {
+    for (klog_sink_t *sink = klog_sinks; sink != NULL; sink = sink->next) {
+        if ((int8_t)rec->level <= sink->klog_sink_level) {
+            sink->klog_sink_write(sink, rec);
+        }
+    }
+}
+
+// 填写记录头，size 与 seq 由调用者设置
+static void klog_fill(klog_record_t *rec, size_t len, uint8_t level,
+                      uint8_t flags, uint8_t color) {
+    rec->len   = len;
+    rec->tsc   = cpu_rdtsc();
+    rec->level = level;
+    rec->cpu   = cpu_get_id();
+    rec->flags = flags;
+    rec->color = color;
+}
+
+// 紧急模式下在栈上格式化并直接交给输出设备
+static int32_t klog_vwrite_direct(uint8_t level, uint8_t flags, uint8_t color,
+                                  const char *fmt, va_list args) {
+    union {
+        klog_record_t rec;
+        uint8_t       buf[sizeof(klog_record_t) + KLOG_TEXT_MAX];
+    } msg;
+    int32_t res = vsnprintf(msg.rec.text, KLOG_TEXT_MAX, fmt, args);
+    size_t  len = (size_t)res < KLOG_TEXT_MAX ? (size_t)res : KLOG_TEXT_MAX - 1;
+    klog_fill(&msg.rec, len, level, flags, color);
+    msg.rec.seq  = __sync_fetch_and_add(&klog_seq, 1);
+    msg.rec.size = KLOG_ALIGN(sizeof(klog_record_t) + len);
+    klog_deliver(&msg.rec);
+    return res;
+}
+
+int32_t klog_vwrite(uint8_t level, uint8_t flags, uint8_t color,
+                    const char *fmt, va_list args) {
+    // 没有输出设备需要时不格式化
+    if ((int8_t)level > klog_sinks_level) {
+        return 0;
+    }
+    if (klog_emergency_mode == true) {
+        return klog_vwrite_direct(level, flags, color, fmt, args);
+    }
+    // 先格式化到栈上，得到长度后再预留空间，预留期间不调用其它函数
+    char    buf[KLOG_TEXT_MAX];
+    int32_t res = vsnprintf(buf, sizeof(buf), fmt, args);
+    size_t  len = (size_t)res < sizeof(buf) ? (size_t)res : sizeof(buf) - 1;
+    uint32_t       size = KLOG_ALIGN(sizeof(klog_record_t) + len);
+    klog_record_t *rec  = klog_reserve(size);
+    if (rec != NULL) {
+        klog_fill(rec, len, level, flags, color);
+        rec->seq = __sync_fetch_and_add(&klog_seq, 1);
+        memcpy(rec->text, buf, len);
+        // 记录写完后才提交
+        __asm__ volatile("" : : : "memory");
+        rec->size = size;
+    }
+    if (klog_deferred == false) {
+        klog_flush();
+    }
+    return res;
+}
+
+// 报告新丢失的记录
+static void klog_report_lost(void) {
+    uint32_t lost = klog_lost;
+    if (lost == klog_lost_reported) {
+        return;
+    }
+    union {
+        klog_record_t rec;
+        uint8_t       buf[sizeof(klog_record_t) + 32];
+    } msg;
+    int32_t len = snprintf(msg.rec.text, 32, "klog: %u lost\n",
+                           lost - klog_lost_reported);
+    msg.rec.size = sizeof(msg);
+    msg.rec.seq  = klog_seq;
+    klog_fill(&msg.rec, len, KLOG_ERR, KLOG_PREFIX, klog_level_color(KLOG_ERR));
+    klog_lost_reported = lost;
+    klog_deliver(&msg.rec);
+}
+
+uint32_t klog_flush(void) {
+    // 输出设备较慢，只允许一个调用者输出，嵌套的调用直接返回
+    if (__sync_lock_test_and_set(&klog_busy, 1) != 0) {
+        return 0;
+    }
+    uint32_t count = 0;
+    uint32_t tail  = klog_tail;
+    while (tail != klog_head) {
+        klog_record_t *rec =
+            (klog_record_t *)&klog_ring[tail & (KLOG_RING_SIZE - 1)];
+        uint32_t size = rec->size;
+        // 已预留但还没有写完，之后的记录等下次再输出
+        if (size == 0) {
+            break;
+        }
+        __asm__ volatile("" : : : "memory");
+        if (rec->len != KLOG_PAD) {
+            klog_deliver(rec);
+            count++;
+        }
+        // 清零后才释放空间
+        bzero(rec, size);
+        __asm__ volatile("" : : : "memory");
+        tail += size;
+        klog_tail = tail;
+    }
+    klog_report_lost();
+    __sync_lock_release(&klog_busy);
+    return count;
+}
+
+bool klog_set_deferred(bool deferred) {
+    bool old      = klog_deferred;
+    klog_deferred = deferred;
+    if (deferred == false) {
+        klog_flush();
+    }
+    return old;
+}
+
+void klog_emergency(void) {
+    klog_deferred       = false;
+    klog_emergency_mode = true;
+    // 持有输出权的 klog_flush 可能正是被打断的代码，不会再继续
+    __sync_lock_release(&klog_busy);
+    klog_flush();
+}
+
+// 重新计算所有输出设备级别的最大值，调用前需关中断
+static void klog_update_level(void) {
+    int8_t level = KLOG_OFF;
+    for (klog_sink_t *sink = klog_sinks; sink != NULL; sink = sink->next) {
+        if (sink->klog_sink_level > level) {
+            level = sink->klog_sink_level;
+        }
+    }
+    klog_sinks_level = level;
+}
+
+// 在内核命令行中查找 <prefix>.<name>=<级别>，没有时返回 def
+static int8_t klog_cmdline_level(const char *prefix, const char *name,
+                                 int8_t def) {
+    char opt[64];
+    snprintf(opt, sizeof(opt), "%s.%s=off", prefix, name);
+    if (multiboot2_cmdline_has(opt) == true) {
+        return KLOG_OFF;
+    }
+    for (int8_t level = 0; level < KLOG_LEVEL_MAX; level++) {
+        snprintf(opt, sizeof(opt), "%s.%s=%s", prefix, name,
+                 klog_level_name[level]);
+        if (multiboot2_cmdline_has(opt) == true) {
+            return level;
+        }
+    }
+    return def;
+}
+
+// 按内核命令行设置 sink 的级别，调用前需关中断
+static void klog_apply_cmdline(klog_sink_t *sink) {
+    sink->klog_sink_level =
+        klog_cmdline_level("klog", sink->klog_sink_name, sink->klog_sink_level);
+}
+
+void klog_register_sink(klog_sink_t *sink) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    klog_sink_t **link = &klog_sinks;
+    while (*link != NULL) {
+        link = &(*link)->next;
+    }
+    sink->next = NULL;
+    *link      = sink;
+    klog_apply_cmdline(sink);
+    klog_update_level();
+    local_intr_restore(intr_flag);
+}
+
+void klog_unregister_sink(klog_sink_t *sink) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    for (klog_sink_t **link = &klog_sinks; *link != NULL;
+         link               = &(*link)->next) {
+        if (*link == sink) {
+            *link = sink->next;
+            break;
+        }
+    }
+    klog_update_level();
+    local_intr_restore(intr_flag);
+}
+
+void klog_sink_set_level(klog_sink_t *sink, int8_t level) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    sink->klog_sink_level = level;
+    klog_update_level();
+    local_intr_restore(intr_flag);
+}
+
+void klog_sys_set_level(uint32_t sys, int8_t level) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    for (int8_t i = 0; i < KLOG_LEVEL_MAX; i++) {
+        if (i <= level) {
+            klog_mask[i] |= 1U << sys;
+        }
+        else {
+            klog_mask[i] &= ~(1U << sys);
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+void klog_init(void) {
+    for (uint32_t sys = 0; sys < KLOG_SYS_MAX; sys++) {
+        int8_t level = klog_cmdline_level("log", klog_sys_name[sys],
+                                          KLOG_LEVEL_MAX);
+        if (level != KLOG_LEVEL_MAX) {
+            klog_sys_set_level(sys, level);
+        }
+    }
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    for (klog_sink_t *sink = klog_sinks; sink != NULL; sink = sink->next) {
+        klog_apply_cmdline(sink);
+    }
+    klog_update_level();
+    local_intr_restore(intr_flag);
+    printk_info("klog_init\n");
+}
+
+uint32_t klog_dropped(void) {
+    return klog_lost;
+}
+
+#ifdef __cplusplus
+}
+#endif
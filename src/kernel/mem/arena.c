@@ -0,0 +1,81 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// arena.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "pmm.h"
+#include "arena.h"
+
+// 块中第一个可用地址
+static inline ptr_t arena_block_start(arena_block_t *block) {
+    return (ptr_t)(block + 1);
+}
+
+// 块的结束地址
+static inline ptr_t arena_block_end(arena_block_t *block) {
+    return (ptr_t)block + block->pages * PMM_PAGE_SIZE;
+}
+
+// 释放 block 之后的所有块
+static void arena_free_until(arena_t *arena, arena_block_t *block) {
+    while (arena->block != block) {
+        arena_block_t *prev = arena->block->prev;
+        pmm_free_page((ptr_t)arena->block, arena->block->pages, NORMAL);
+        arena->block = prev;
+    }
+    return;
+}
+
+void arena_init(arena_t *arena) {
+    arena->block = NULL;
+    arena->cur   = 0;
+    arena->end   = 0;
+    return;
+}
+
+void *arena_alloc_slow(arena_t *arena, size_t size) {
+    if (size > ARENA_SIZE_MAX) {
+        return NULL;
+    }
+    // 一般只需要一页，过大的请求单独占用一块
+    uint32_t pages =
+        (size + sizeof(arena_block_t) + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+    // 先检查空闲页数，pmm 在内存不足时报错后会停机
+    ptr_t pa = (ptr_t)-1;
+    if (pmm_free_pages_count(NORMAL) >= pages) {
+        pa = pmm_alloc_page(pages, NORMAL);
+    }
+    if (pa == (ptr_t)-1) {
+        printk_err_nohalt("arena_alloc: No enough phy mem.\n");
+        return NULL;
+    }
+    arena_block_t *block = (arena_block_t *)pa;
+    block->prev          = arena->block;
+    block->pages         = pages;
+    arena->block         = block;
+    arena->cur           = arena_block_start(block) + size;
+    arena->end           = arena_block_end(block);
+    return (void *)arena_block_start(block);
+}
+
+void arena_reset(arena_t *arena, arena_mark_t mark) {
+    arena_free_until(arena, mark.block);
+    arena->cur = mark.cur;
+    arena->end = (mark.block != NULL) ? arena_block_end(mark.block) : 0;
+    return;
+}
+
+void arena_destroy(arena_t *arena) {
+    arena_free_until(arena, NULL);
+    arena_init(arena);
+    return;
+}
+
+#ifdef __cplusplus
+}
+#endif
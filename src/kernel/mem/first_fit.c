@@ -21,13 +21,15 @@ extern "C" {
 static void init(void);
 // 分配
 static ptr_t alloc(uint32_t bytes, int8_t zone);
+// 按对齐要求分配
+static ptr_t alloc_align(uint32_t pages, uint32_t align, int8_t zone);
 // 释放
 static void free(ptr_t addr_start, uint32_t bytes, int8_t zone);
 // 空闲数量
 static uint32_t free_pages_count(int8_t zone);
 
-pmm_manage_t firstfit_manage = {"Fitst Fit", &init, &alloc, &free,
-                                &free_pages_count};
+pmm_manage_t firstfit_manage = {"Fitst Fit",       &init, &alloc, &free,
+                                &free_pages_count, &alloc_align};
 
 firstfit_manage_t ff_manage_dma;
 firstfit_manage_t ff_manage_normal;
@@ -113,12 +115,10 @@ void init() {
     // 每个分区初始化一个管理器
     // 将 DMA 区域的空闲链表放在地址为 0 的位置
     // NORMAL 区域的空闲链表放在 16MB 处
-    // HIGHMEM 放在 110MB 处
+    // HIGHMEM 放在 NORMAL 之后
     list_entry_t *dma_pmm_info = (list_entry_t *)((ptr_t)(DMA_START_ADDR));
     list_entry_t *normal_pmm_info =
         (list_entry_t *)((ptr_t)(NORMAL_START_ADDR));
-    list_entry_t *highmem_pmm_info =
-        (list_entry_t *)((ptr_t)(HIGHMEM_START_ADDR));
     // 最差情况，一块只有一个页，所以预先留好空间存储这些块信息
     // 管理所有内存页需要的空间，供管理结构使用
     uint32_t dma_pmm_info_size = mem_zone[DMA].all_pages * sizeof(list_entry_t);
@@ -126,6 +126,12 @@ void init() {
         mem_zone[NORMAL].all_pages * sizeof(list_entry_t);
     uint32_t highmem_pmm_info_size =
         mem_zone[HIGHMEM].all_pages * sizeof(list_entry_t);
+    // HIGHMEM 不在直接映射区内，开启分页后无法直接访问，
+    // 所以其管理信息放在 NORMAL 区管理信息之后
+    list_entry_t *highmem_pmm_info =
+        (list_entry_t *)((ptr_t)(NORMAL_START_ADDR) +
+                         ((normal_pmm_info_size + PMM_PAGE_SIZE - 1) &
+                          PMM_PAGE_MASK));
     bzero(dma_pmm_info, dma_pmm_info_size);
     bzero(normal_pmm_info, normal_pmm_info_size);
     bzero(highmem_pmm_info, highmem_pmm_info_size);
@@ -138,8 +144,9 @@ void init() {
          i < NORMAL_START_ADDR + normal_pmm_info_size; i += PMM_PAGE_SIZE) {
         mem_page[i / (unsigned int)PMM_PAGE_SIZE].ref = 1;
     }
-    for (unsigned int i = HIGHMEM_START_ADDR;
-         i < HIGHMEM_START_ADDR + highmem_pmm_info_size; i += PMM_PAGE_SIZE) {
+    for (unsigned int i = (ptr_t)highmem_pmm_info;
+         i < (ptr_t)highmem_pmm_info + highmem_pmm_info_size;
+         i += PMM_PAGE_SIZE) {
         mem_page[i / (unsigned int)PMM_PAGE_SIZE].ref = 1;
     }
     // mem_page 数组的指示变量
@@ -161,6 +168,8 @@ void init() {
         // 中转节点
         list_entry_t *before    = NULL;
         ptr_t         info_addr = 0;
+        // 分区起始地址
+        ptr_t zone_addr = 0;
         // 头节点
         list_entry_t *pmm_info_head = NULL;
         // 中间节点
@@ -168,16 +177,24 @@ void init() {
         if (z == DMA) {
             i         = dma_pmm_info_size / PMM_PAGE_SIZE + 1;
             info_addr = (ptr_t)DMA_START_ADDR;
+            zone_addr = (ptr_t)DMA_START_ADDR;
         }
         else if (z == NORMAL) {
-            i         = normal_pmm_info_size / PMM_PAGE_SIZE + 1;
+            // 跳过 NORMAL 与 HIGHMEM 的管理信息
+            i = ((ptr_t)highmem_pmm_info + highmem_pmm_info_size -
+                 NORMAL_START_ADDR) /
+                    PMM_PAGE_SIZE +
+                1;
             info_addr = (ptr_t)NORMAL_START_ADDR;
+            zone_addr = (ptr_t)NORMAL_START_ADDR;
         }
         else if (z == HIGHMEM) {
-            i         = highmem_pmm_info_size / PMM_PAGE_SIZE + 1;
-            info_addr = (ptr_t)HIGHMEM_START_ADDR;
+            i         = 0;
+            info_addr = (ptr_t)highmem_pmm_info;
+            zone_addr = (ptr_t)HIGHMEM_START_ADDR;
         }
-        k = i;
+        // mem_page 数组下标需要加上分区起始页
+        k = i + (uint32_t)(zone_addr / PMM_PAGE_SIZE);
 
         /*
          需要解决两种情况
@@ -242,6 +259,7 @@ void init() {
             ff_manage_dma.phy_page_count     = mem_zone[z].all_pages;
             ff_manage_dma.phy_page_now_count = mem_zone[z].free_pages;
             ff_manage_dma.node_num           = num;
+            ff_manage_dma.node_free = NULL;
             // (list_entry_t *)(ptr_t)DMA_START_ADDR;
             ff_manage_dma.free_list = pmm_info_head;
         }
@@ -249,6 +267,7 @@ void init() {
             ff_manage_normal.phy_page_count     = mem_zone[z].all_pages;
             ff_manage_normal.phy_page_now_count = mem_zone[z].free_pages;
             ff_manage_normal.node_num           = num;
+            ff_manage_normal.node_free = NULL;
             // (list_entry_t *)(ptr_t)NORMAL_START_ADDR;
             ff_manage_normal.free_list = pmm_info_head;
         }
@@ -256,6 +275,7 @@ void init() {
             ff_manage_highmem.phy_page_count     = mem_zone[z].all_pages;
             ff_manage_highmem.phy_page_now_count = mem_zone[z].free_pages;
             ff_manage_highmem.node_num           = num;
+            ff_manage_highmem.node_free = NULL;
             // (list_entry_t *)(ptr_t)HIGHMEM_START_ADDR;
             ff_manage_highmem.free_list = pmm_info_head;
         }
@@ -312,6 +332,58 @@ void init() {
     return;
 }
 
+// 根据分区找到对应的管理器
+static firstfit_manage_t *get_manage(int8_t zone) {
+    if (zone == DMA) {
+        return &ff_manage_dma;
+    }
+    else if (zone == NORMAL) {
+        return &ff_manage_normal;
+    }
+    else if (zone == HIGHMEM) {
+        return &ff_manage_highmem;
+    }
+    printk_err("zone is invalid\n");
+    return NULL;
+}
+
+// 获取一个链表节点，优先重用合并时删除的节点
+static list_entry_t *node_alloc(firstfit_manage_t *ff_manage) {
+    list_entry_t *node = ff_manage->node_free;
+    if (node != NULL) {
+        ff_manage->node_free = node->next;
+        return node;
+    }
+    // 节点存放在管理信息数组的末尾
+    node = ff_manage->free_list + ff_manage->node_num;
+    ff_manage->node_num++;
+    return node;
+}
+
+// 回收合并时删除的节点
+static void node_release(firstfit_manage_t *ff_manage, list_entry_t *node) {
+    node->next           = ff_manage->node_free;
+    ff_manage->node_free = node;
+    return;
+}
+
+// 将 entry 拆分为 pages 页和剩余部分，剩余部分作为新的空闲节点
+static void split(firstfit_manage_t *ff_manage, list_entry_t *entry,
+                  uint32_t pages) {
+    if (list_chunk_info(entry)->npages <= pages) {
+        return;
+    }
+    list_entry_t *tmp = node_alloc(ff_manage);
+    list_chunk_info(tmp)->addr =
+        list_chunk_info(entry)->addr + pages * PMM_PAGE_SIZE;
+    list_chunk_info(tmp)->npages = list_chunk_info(entry)->npages - pages;
+    list_chunk_info(tmp)->ref    = 0;
+    list_chunk_info(tmp)->flag   = FF_UNUSED;
+    list_add_after(entry, tmp);
+    list_chunk_info(entry)->npages = pages;
+    return;
+}
+
 // 根据线性地址判断属于那个管理区，然后使用对应的物理分区管理器进行分配。
 ptr_t alloc(uint32_t bytes, int8_t zone) {
     // 计算需要的页数
@@ -320,64 +392,47 @@ ptr_t alloc(uint32_t bytes, int8_t zone) {
     if (bytes % PMM_PAGE_SIZE != 0) {
         pages += 1;
     }
+    return alloc_align(pages, 1, zone);
+}
 
-    // 首先根据分区找到对应的管理器，然后找到地址对应的管理节点
-    firstfit_manage_t *ff_manage = NULL;
-    if (zone == DMA) {
-        ff_manage = &ff_manage_dma;
-    }
-    else if (zone == NORMAL) {
-        ff_manage = &ff_manage_normal;
-    }
-    else if (zone == HIGHMEM) {
-        ff_manage = &ff_manage_highmem;
+// 分配 pages 个页，起始地址按 align 个页对齐，align 需为 2 的幂
+ptr_t alloc_align(uint32_t pages, uint32_t align, int8_t zone) {
+    firstfit_manage_t *ff_manage = get_manage(zone);
+    if (ff_manage == NULL) {
+        return -1;
     }
-    else {
-        printk_err("zone is invalid\n");
+    // 分区中没有可用内存
+    if (ff_manage->free_list == NULL) {
+        printk_err("No enough phy mem.\n");
         return -1;
     }
-    ptr_t         res_addr = 0;
-    list_entry_t *entry    = ff_manage->free_list;
-    // while (entry >= 0) {
-    while (1) {
-        // printk_info("successful-2!\n");
-        // 查找符合长度且未使用的内存
-        // printk_info("addr:%08X\n",list_chunk_info(entry));
-        if ((list_chunk_info(entry)->npages >= pages) &&
-            (list_chunk_info(entry)->flag == FF_UNUSED)) {
-            // 如果剩余大小足够
-            if (list_chunk_info(entry)->npages - pages > 1) {
-                // 添加为新的链表项
-                list_entry_t *tmp =
-                    (list_entry_t *)(entry + ff_manage->node_num *
-                                                 sizeof(list_entry_t));
-                list_chunk_info(tmp)->addr =
-                    entry->chunk_info.addr + pages * PMM_PAGE_SIZE;
-                list_chunk_info(tmp)->npages = entry->chunk_info.npages - pages;
-                list_chunk_info(tmp)->ref    = 0;
-                list_chunk_info(tmp)->flag   = FF_UNUSED;
-                list_add_after(entry, tmp);
+    ptr_t         mask  = align * PMM_PAGE_SIZE - 1;
+    list_entry_t *entry = ff_manage->free_list;
+    do {
+        chunk_info_t *info = list_chunk_info(entry);
+        if (info->flag == FF_UNUSED) {
+            // 对齐后前面空出的页数
+            uint32_t head =
+                (((info->addr + mask) & ~mask) - info->addr) / PMM_PAGE_SIZE;
+            if (info->npages >= head + pages) {
+                // 前面空出的部分保留在原节点中
+                if (head != 0) {
+                    split(ff_manage, entry, head);
+                    entry = list_next(entry);
+                    info  = list_chunk_info(entry);
+                }
+                split(ff_manage, entry, pages);
+                info->ref  = 1;
+                info->flag = FF_USED;
+                ff_manage->phy_page_now_count -= pages;
+                return info->addr;
             }
-            // 不够的话直接分配
-            list_chunk_info(entry)->npages = pages;
-            list_chunk_info(entry)->ref    = 1;
-            list_chunk_info(entry)->flag   = FF_USED;
-            ff_manage->phy_page_now_count -= pages;
-            res_addr = list_chunk_info(entry)->addr;
-            break;
-        }
-        // 没找到的话就查找下一个
-        else if (list_next(entry) != ff_manage->free_list) {
-            entry = list_next(entry);
         }
-        // 执行到这里还没找见的话，物理内存已经全部查找过了，说明物理内存不够
-        else {
-            printk_err("No enough phy mem.\n");
-            res_addr = -1;
-            break;
-        }
-    }
-    return res_addr;
+        entry = list_next(entry);
+    } while (entry != ff_manage->free_list);
+    // 物理内存已经全部查找过了，说明物理内存不够
+    printk_err("No enough phy mem.\n");
+    return -1;
 }
 
 void free(ptr_t addr_start, uint32_t bytes, int8_t zone) {
@@ -414,22 +469,30 @@ void free(ptr_t addr_start, uint32_t bytes, int8_t zone) {
     list_chunk_info(entry)->ref  = 0;
     list_chunk_info(entry)->flag = FF_UNUSED;
 
-    // 如果于相邻链表有空闲的则合并
+    // 如果于相邻链表有空闲的则合并，链表是循环的，需要确认地址相邻
     // 后面
     if (entry->next != entry &&
-        list_chunk_info(entry->next)->flag == FF_UNUSED) {
+        list_chunk_info(entry->next)->flag == FF_UNUSED &&
+        list_chunk_info(entry)->addr +
+                list_chunk_info(entry)->npages * PMM_PAGE_SIZE ==
+            list_chunk_info(entry->next)->addr) {
         list_entry_t *next = entry->next;
         list_chunk_info(entry)->npages += list_chunk_info(next)->npages;
         list_chunk_info(next)->npages = 0;
         list_del(next);
+        node_release(ff_manage, next);
     }
     // 前面
     if (entry->prev != entry &&
-        list_chunk_info(entry->prev)->flag == FF_UNUSED) {
+        list_chunk_info(entry->prev)->flag == FF_UNUSED &&
+        list_chunk_info(entry->prev)->addr +
+                list_chunk_info(entry->prev)->npages * PMM_PAGE_SIZE ==
+            list_chunk_info(entry)->addr) {
         list_entry_t *prev = entry->prev;
         list_chunk_info(prev)->npages += list_chunk_info(entry)->npages;
         list_chunk_info(entry)->npages = 0;
         list_del(entry);
+        node_release(ff_manage, entry);
     }
     ff_manage->phy_page_now_count += pages;
     return;
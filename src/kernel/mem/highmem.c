@@ -0,0 +1,160 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// highmem.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "assert.h"
+#include "cpu.hpp"
+#include "sync.hpp"
+#include "vmm.h"
+#include "highmem.h"
+
+// kmap 区页表项，持久映射区与固定映射区位于同一个页表中
+static pte_t *kmap_pte;
+// 持久映射的引用计数
+// 0: 空闲；1: 已无人使用，但 TLB 可能还未刷新；n: 有 n - 1 个使用者
+static uint32_t pkmap_count[VMM_PKMAP_NR];
+// 下一次查找空闲槽的起始位置
+static uint32_t pkmap_last;
+// 每个 CPU 已使用的固定映射槽数量
+static uint32_t kmap_atomic_idx[CPU_MAX];
+
+// 槽位编号与虚拟地址的转换
+#define PKMAP_ADDR(nr) (VMM_PKMAP_START + (nr)*VMM_PAGE_SIZE)
+#define PKMAP_NR(addr) (((ptr_t)(addr)-VMM_PKMAP_START) / VMM_PAGE_SIZE)
+#define FIXMAP_ADDR(idx) (VMM_FIXMAP_START + (idx)*VMM_PAGE_SIZE)
+#define FIXMAP_IDX(addr) (((ptr_t)(addr)-VMM_FIXMAP_START) / VMM_PAGE_SIZE)
+// 槽位对应的页表项
+#define KMAP_PTE(addr) (&kmap_pte[VMM_PTE_INDEX(addr)])
+
+// 回收所有计数为 1 的槽，一次刷新所有 TLB
+static void pkmap_flush_unused(void) {
+    for (uint32_t i = 0; i < VMM_PKMAP_NR; i++) {
+        if (pkmap_count[i] != 1) {
+            continue;
+        }
+        pkmap_count[i]           = 0;
+        *KMAP_PTE(PKMAP_ADDR(i)) = 0;
+        vmm_tlb_queue(PKMAP_ADDR(i));
+    }
+    vmm_tlb_flush();
+    return;
+}
+
+// 查找 pa 已有的持久映射，没有时返回 VMM_PKMAP_NR
+static uint32_t pkmap_find(ptr_t pa) {
+    for (uint32_t i = 0; i < VMM_PKMAP_NR; i++) {
+        if (pkmap_count[i] != 0 &&
+            (*KMAP_PTE(PKMAP_ADDR(i)) & VMM_PAGE_MASK) == pa) {
+            return i;
+        }
+    }
+    return VMM_PKMAP_NR;
+}
+
+// 分配一个空闲槽并建立映射，没有空闲槽时返回 VMM_PKMAP_NR
+static uint32_t pkmap_new(ptr_t pa) {
+    for (uint32_t n = 0; n < VMM_PKMAP_NR; n++) {
+        pkmap_last = (pkmap_last + 1) % VMM_PKMAP_NR;
+        // 绕回起点时回收不再使用的槽
+        if (pkmap_last == 0) {
+            pkmap_flush_unused();
+        }
+        if (pkmap_count[pkmap_last] == 0) {
+            *KMAP_PTE(PKMAP_ADDR(pkmap_last)) = pa | VMM_PAGE_KERNEL;
+            pkmap_count[pkmap_last]           = 1;
+            return pkmap_last;
+        }
+    }
+    return VMM_PKMAP_NR;
+}
+
+void kmap_init(void) {
+    // 持久映射区和固定映射区共用一个页表
+    kmap_pte = vmm_get_pte(pgd_kernel, VMM_PKMAP_START, true);
+    assert(kmap_pte != NULL, "kmap_init: No enough phy mem.\n");
+    kmap_pte -= VMM_PTE_INDEX(VMM_PKMAP_START);
+    for (uint32_t i = 0; i < VMM_PKMAP_NR; i++) {
+        pkmap_count[i] = 0;
+    }
+    pkmap_last = 0;
+    for (uint32_t i = 0; i < CPU_MAX; i++) {
+        kmap_atomic_idx[i] = 0;
+    }
+    printk_info("kmap_init\n");
+    return;
+}
+
+void *kmap(ptr_t pa) {
+    if (PMM_IS_HIGHMEM(pa) == false) {
+        return (void *)pa;
+    }
+    ptr_t offset    = pa & ~VMM_PAGE_MASK;
+    bool  intr_flag = false;
+    pa &= VMM_PAGE_MASK;
+    local_intr_store(intr_flag);
+    uint32_t nr = pkmap_find(pa);
+    if (nr == VMM_PKMAP_NR) {
+        nr = pkmap_new(pa);
+    }
+    if (nr != VMM_PKMAP_NR) {
+        pkmap_count[nr]++;
+    }
+    local_intr_restore(intr_flag);
+    if (nr == VMM_PKMAP_NR) {
+        printk_err("kmap: No free pkmap slot.\n");
+        return NULL;
+    }
+    return (void *)(PKMAP_ADDR(nr) + offset);
+}
+
+void kunmap(void *addr) {
+    if ((ptr_t)addr < VMM_PKMAP_START || (ptr_t)addr >= VMM_PKMAP_END) {
+        return;
+    }
+    uint32_t nr        = PKMAP_NR(addr);
+    bool     intr_flag = false;
+    local_intr_store(intr_flag);
+    assert(pkmap_count[nr] > 1, "kunmap: Bad address.\n");
+    // 计数降为 1 时保留映射，等待统一刷新 TLB 后再重用
+    pkmap_count[nr]--;
+    local_intr_restore(intr_flag);
+    return;
+}
+
+void *kmap_atomic(ptr_t pa) {
+    if (PMM_IS_HIGHMEM(pa) == false) {
+        return (void *)pa;
+    }
+    uint32_t cpu = cpu_get_id();
+    // 中断中的嵌套使用会在返回前释放，所以不需要关中断
+    uint32_t idx = kmap_atomic_idx[cpu]++;
+    assert(idx < VMM_KMAP_ATOMIC_NR, "kmap_atomic: Too many nested maps.\n");
+    ptr_t va = FIXMAP_ADDR(cpu * VMM_KMAP_ATOMIC_NR + idx);
+    *KMAP_PTE(va) = (pa & VMM_PAGE_MASK) | VMM_PAGE_KERNEL;
+    CPU_INVLPG(va);
+    return (void *)(va + (pa & ~VMM_PAGE_MASK));
+}
+
+void kunmap_atomic(void *addr) {
+    if ((ptr_t)addr < VMM_FIXMAP_START || (ptr_t)addr >= VMM_FIXMAP_END) {
+        return;
+    }
+    uint32_t cpu = cpu_get_id();
+    uint32_t idx = kmap_atomic_idx[cpu] - 1;
+    assert(FIXMAP_IDX(addr) == cpu * VMM_KMAP_ATOMIC_NR + idx,
+           "kunmap_atomic: Unbalanced unmap.\n");
+    // 槽位重用时 kmap_atomic 会刷新该页，这里只清除页表项
+    *KMAP_PTE((ptr_t)addr) = 0;
+    kmap_atomic_idx[cpu]   = idx;
+    return;
+}
+
+#ifdef __cplusplus
+}
+#endif
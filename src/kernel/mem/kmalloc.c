@@ -0,0 +1,191 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// kmalloc.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "assert.h"
+#include "pmm.h"
+#include "multiboot2.h"
+#include "slab.h"
+#include "memprof.h"
+#include "kmalloc.h"
+
+static void * normal_alloc(size_t size, uint32_t flags);
+static void   normal_free(void *ptr);
+static size_t normal_size(const void *ptr);
+
+const heap_manage_t kmalloc_normal_manage = {"Normal", &normal_alloc,
+                                             &normal_free, &normal_size};
+
+// 当前使用的堆管理器
+static const heap_manage_t *heap_manager = &kmalloc_normal_manage;
+
+// 各大小类别的 cache
+static kmem_cache_t *kmalloc_caches[KMALLOC_CACHES];
+static const char *const kmalloc_names[KMALLOC_CACHES] = {
+    "kmalloc-8",   "kmalloc-16",  "kmalloc-32",  "kmalloc-64",  "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024", "kmalloc-2048"};
+
+// size 对应的大小类别
+static inline uint32_t kmalloc_index(size_t size) {
+    uint32_t idx = 0;
+    for (size_t s = KMALLOC_MIN_SIZE; s < size; s <<= 1) {
+        idx++;
+    }
+    return idx;
+}
+
+// 大块内存直接从 pmm 分配
+static void *kmalloc_large(size_t size) {
+    // 加上头部并按页取整时不能溢出
+    if (size > (size_t)-1 - sizeof(kmalloc_large_t) - (PMM_PAGE_SIZE - 1)) {
+        return NULL;
+    }
+    uint32_t pages =
+        (size + sizeof(kmalloc_large_t) + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+    ptr_t pa = pmm_alloc_page(pages, NORMAL);
+    if (pa == (ptr_t)-1) {
+        return NULL;
+    }
+    kmalloc_large_t *large = (kmalloc_large_t *)pa;
+    large->magic           = KMALLOC_LARGE_MAGIC;
+    large->pages           = pages;
+    return large + 1;
+}
+
+// 获取大块内存的头部，ptr 不是大块内存时返回 NULL
+static kmalloc_large_t *kmalloc_large_get(const void *ptr) {
+    kmalloc_large_t *large = (kmalloc_large_t *)ptr - 1;
+    if (((ptr_t)large & ~PMM_PAGE_MASK) != 0 ||
+        large->magic != KMALLOC_LARGE_MAGIC) {
+        return NULL;
+    }
+    return large;
+}
+
+void kmalloc_init(void) {
+    size_t size = KMALLOC_MIN_SIZE;
+    for (uint32_t i = 0; i < KMALLOC_CACHES; i++) {
+        kmalloc_caches[i] =
+            kmem_cache_create(kmalloc_names[i], size, KMALLOC_MIN_SIZE, NULL);
+        assert(kmalloc_caches[i] != NULL, "kmalloc_init: No enough phy mem.\n");
+        size <<= 1;
+    }
+    if (multiboot2_cmdline_has("kmalloc_debug") == true) {
+        kmalloc_set_manage(&kmalloc_debug_manage);
+    }
+    printk_info("kmalloc_init: %s\n", heap_manager->name);
+    return;
+}
+
+void kmalloc_set_manage(const heap_manage_t *manage) {
+    heap_manager = manage;
+    return;
+}
+
+void *kmalloc(size_t size, uint32_t flags) {
+    void *ptr = heap_manager->heap_manage_alloc(size, flags);
+    if (ptr != NULL) {
+        memprof_alloc(MEMPROF_HEAP, (ptr_t)ptr, size,
+                      (ptr_t)__builtin_return_address(0));
+    }
+    return ptr;
+}
+
+void kfree(void *ptr) {
+    if (ptr != NULL) {
+        memprof_free(MEMPROF_HEAP, (ptr_t)ptr);
+    }
+    heap_manager->heap_manage_free(ptr);
+    return;
+}
+
+size_t ksize(const void *ptr) {
+    return heap_manager->heap_manage_size(ptr);
+}
+
+void *normal_alloc(size_t size, uint32_t flags) {
+    if (size == 0) {
+        return NULL;
+    }
+    void *ptr = NULL;
+    if (size <= KMALLOC_MAX_SIZE) {
+        ptr = kmem_cache_alloc(kmalloc_caches[kmalloc_index(size)]);
+    }
+    else {
+        ptr = kmalloc_large(size);
+    }
+    if (ptr != NULL && (flags & KMALLOC_ZERO)) {
+        bzero(ptr, size);
+    }
+    return ptr;
+}
+
+void normal_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    slab_t *slab = slab_get(ptr);
+    if (slab != NULL) {
+        kmem_cache_free(slab->cache, ptr);
+        return;
+    }
+    kmalloc_large_t *large = kmalloc_large_get(ptr);
+    if (large == NULL) {
+        printk_err("kfree: Bad pointer 0x%08X\n", ptr);
+        return;
+    }
+    large->magic = 0;
+    pmm_free_page((ptr_t)large, large->pages, NORMAL);
+    return;
+}
+
+size_t normal_size(const void *ptr) {
+    if (ptr == NULL) {
+        return 0;
+    }
+    slab_t *slab = slab_get(ptr);
+    if (slab != NULL) {
+        return slab->cache->size;
+    }
+    kmalloc_large_t *large = kmalloc_large_get(ptr);
+    if (large == NULL) {
+        return 0;
+    }
+    return large->pages * PMM_PAGE_SIZE - sizeof(kmalloc_large_t);
+}
+
+void *krealloc(void *ptr, size_t size, uint32_t flags) {
+    if (ptr == NULL) {
+        return kmalloc(size, flags);
+    }
+    if (size == 0) {
+        kfree(ptr);
+        return NULL;
+    }
+    size_t old_size = ksize(ptr);
+    // 当前的容量已经足够
+    if (size <= old_size) {
+        return ptr;
+    }
+    void *new_ptr = kmalloc(size, flags & ~KMALLOC_ZERO);
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, old_size);
+    if (flags & KMALLOC_ZERO) {
+        bzero((uint8_t *)new_ptr + old_size, size - old_size);
+    }
+    kfree(ptr);
+    return new_ptr;
+}
+
+#ifdef __cplusplus
+}
+#endif
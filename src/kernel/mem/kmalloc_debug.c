@@ -0,0 +1,141 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// kmalloc_debug.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "slab.h"
+#include "kmalloc.h"
+
+// 对象头部的魔数
+// 使用中
+#define DEBUG_MAGIC_ALLOC (0xA110CA7EUL)
+// 已释放
+#define DEBUG_MAGIC_FREE (0xF7EEF7EEUL)
+// 保护区大小
+#define DEBUG_REDZONE_SIZE (16)
+// 保护区填充值
+#define DEBUG_REDZONE (0xBB)
+// 释放后的填充值
+#define DEBUG_POISON (0x6B)
+
+// 调试模式下每个对象的头部，其后依次是前保护区、对象、后保护区
+typedef struct debug_header {
+    uint32_t magic;
+    // 请求的字节数
+    uint32_t size;
+    uint32_t reserved[2];
+} debug_header_t;
+
+static void * debug_alloc(size_t size, uint32_t flags);
+static void   debug_free(void *ptr);
+static size_t debug_size(const void *ptr);
+
+const heap_manage_t kmalloc_debug_manage = {"Debug", &debug_alloc,
+                                            &debug_free, &debug_size};
+
+// 已发现的错误数量
+static uint32_t debug_errors;
+
+// 前保护区
+static inline uint8_t *debug_redzone_front(debug_header_t *hdr) {
+    return (uint8_t *)(hdr + 1);
+}
+
+// 返回给调用者的地址
+static inline uint8_t *debug_obj(debug_header_t *hdr) {
+    return debug_redzone_front(hdr) + DEBUG_REDZONE_SIZE;
+}
+
+static inline debug_header_t *debug_header(const void *ptr) {
+    return (debug_header_t *)((ptr_t)ptr - DEBUG_REDZONE_SIZE -
+                              sizeof(debug_header_t));
+}
+
+// 检查 len 字节是否都为 val
+static bool debug_check(const uint8_t *p, uint32_t len, uint8_t val) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (p[i] != val) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void debug_report(const char *what, const void *ptr) {
+    debug_errors++;
+    // 错误由调用者通过 kmalloc_debug_errors() 检查，不停机
+    printk_err_nohalt("kmalloc_debug: %s at 0x%08X\n", what, ptr);
+    return;
+}
+
+void *debug_alloc(size_t size, uint32_t flags) {
+    if (size == 0) {
+        return NULL;
+    }
+    debug_header_t *hdr = kmalloc_normal_manage.heap_manage_alloc(
+        sizeof(debug_header_t) + size + 2 * DEBUG_REDZONE_SIZE, KMALLOC_NORMAL);
+    if (hdr == NULL) {
+        return NULL;
+    }
+    // 重新分配到已释放的对象时，检查释放后是否被写入
+    // 大块内存会归还 pmm 并被其它模块使用，只检查 slab 中的对象
+    if (hdr->magic == DEBUG_MAGIC_FREE && slab_get(hdr) != NULL &&
+        debug_check(debug_obj(hdr), hdr->size, DEBUG_POISON) == false) {
+        debug_report("use after free", debug_obj(hdr));
+    }
+    hdr->magic = DEBUG_MAGIC_ALLOC;
+    hdr->size  = size;
+    memset(debug_redzone_front(hdr), DEBUG_REDZONE, DEBUG_REDZONE_SIZE);
+    memset(debug_obj(hdr) + size, DEBUG_REDZONE, DEBUG_REDZONE_SIZE);
+    // 未清零的内存填充毒值，便于发现未初始化的使用
+    memset(debug_obj(hdr), (flags & KMALLOC_ZERO) ? 0 : DEBUG_POISON, size);
+    return debug_obj(hdr);
+}
+
+void debug_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    debug_header_t *hdr = debug_header(ptr);
+    if (hdr->magic == DEBUG_MAGIC_FREE) {
+        debug_report("double free", ptr);
+        return;
+    }
+    if (hdr->magic != DEBUG_MAGIC_ALLOC) {
+        debug_report("bad pointer", ptr);
+        return;
+    }
+    if (debug_check(debug_redzone_front(hdr), DEBUG_REDZONE_SIZE,
+                    DEBUG_REDZONE) == false) {
+        debug_report("front redzone overwritten", ptr);
+    }
+    if (debug_check((uint8_t *)ptr + hdr->size, DEBUG_REDZONE_SIZE,
+                    DEBUG_REDZONE) == false) {
+        debug_report("back redzone overwritten", ptr);
+    }
+    hdr->magic = DEBUG_MAGIC_FREE;
+    memset(ptr, DEBUG_POISON, hdr->size);
+    kmalloc_normal_manage.heap_manage_free(hdr);
+    return;
+}
+
+size_t debug_size(const void *ptr) {
+    if (ptr == NULL) {
+        return 0;
+    }
+    return debug_header(ptr)->size;
+}
+
+uint32_t kmalloc_debug_errors(void) {
+    return debug_errors;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,236 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// memprof.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "cpu.hpp"
+#include "sync.hpp"
+#include "pmm.h"
+#include "vmm.h"
+#include "multiboot2.h"
+#include "memprof.h"
+
+// boot.s 中的内核栈
+extern uint8_t STACK[];
+
+bool memprof_enabled;
+
+// 记录池
+static memprof_record_t memprof_records[MEMPROF_RECORDS_MAX];
+// 空闲记录
+static memprof_record_t *memprof_free_list;
+// 按地址索引的哈希表
+static memprof_record_t *memprof_hash[MEMPROF_HASH_SIZE];
+// 调用点统计
+static memprof_site_t memprof_sites[MEMPROF_SITES_MAX];
+static uint32_t       memprof_site_count;
+// 按 (类型, 调用点) 索引的哈希表，线性探测，保存 memprof_sites 的下标加一
+// 调用点只增不删，0 表示空位
+static uint16_t memprof_site_hash[MEMPROF_SITE_HASH_SIZE];
+// 记录池或调用点表已满而丢弃的次数
+static uint32_t memprof_dropped;
+// 标记-扫描时被引用的记录
+static uint8_t memprof_marks[MEMPROF_RECORDS_MAX];
+// 标记-扫描的待扫描记录
+static uint16_t memprof_stack[MEMPROF_RECORDS_MAX];
+
+static inline uint32_t memprof_hash_addr(ptr_t addr) {
+    return (addr >> 3) % MEMPROF_HASH_SIZE;
+}
+
+static inline uint32_t memprof_hash_site(uint32_t type, ptr_t caller) {
+    return (((caller ^ type) * 2654435761U) >> 16) &
+           (MEMPROF_SITE_HASH_SIZE - 1);
+}
+
+// 查找调用点，没有时新建，表满时返回 NULL
+static memprof_site_t *memprof_site(uint32_t type, ptr_t caller) {
+    uint32_t h = memprof_hash_site(type, caller);
+    // 表的大小大于调用点数量，一定能找到空位
+    while (memprof_site_hash[h] != 0) {
+        memprof_site_t *site = &memprof_sites[memprof_site_hash[h] - 1];
+        if (site->caller == caller && site->type == type) {
+            return site;
+        }
+        h = (h + 1) & (MEMPROF_SITE_HASH_SIZE - 1);
+    }
+    if (memprof_site_count == MEMPROF_SITES_MAX) {
+        return NULL;
+    }
+    memprof_site_t *site = &memprof_sites[memprof_site_count++];
+    bzero(site, sizeof(memprof_site_t));
+    site->caller         = caller;
+    site->type           = type;
+    memprof_site_hash[h] = memprof_site_count;
+    return site;
+}
+
+// 查找 addr 对应的记录
+static memprof_record_t *memprof_find(uint32_t type, ptr_t addr) {
+    memprof_record_t *rec = memprof_hash[memprof_hash_addr(addr)];
+    while (rec != NULL && (rec->addr != addr || rec->type != type)) {
+        rec = rec->next;
+    }
+    return rec;
+}
+
+void memprof_init(void) {
+    memprof_free_list = NULL;
+    for (int32_t i = MEMPROF_RECORDS_MAX - 1; i >= 0; i--) {
+        memprof_records[i].next = memprof_free_list;
+        memprof_free_list       = &memprof_records[i];
+    }
+    bzero(memprof_hash, sizeof(memprof_hash));
+    bzero(memprof_site_hash, sizeof(memprof_site_hash));
+    memprof_site_count = 0;
+    memprof_dropped    = 0;
+    memprof_enabled    = multiboot2_cmdline_has("memprof");
+    printk_info("memprof_init: %s\n", memprof_enabled ? "on" : "off");
+    return;
+}
+
+void memprof_enable(bool enable) {
+    memprof_enabled = enable;
+    return;
+}
+
+void memprof_record_alloc(uint32_t type, ptr_t addr, uint32_t size,
+                          ptr_t caller) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    memprof_site_t *  site = memprof_site(type, caller);
+    memprof_record_t *rec  = memprof_free_list;
+    if (site == NULL || rec == NULL) {
+        memprof_dropped++;
+        local_intr_restore(intr_flag);
+        return;
+    }
+    site->allocs++;
+    site->total_bytes += size;
+    site->live++;
+    site->live_bytes += size;
+    memprof_free_list = rec->next;
+    rec->addr         = addr;
+    rec->size         = size;
+    rec->caller       = caller;
+    rec->type         = type;
+    rec->tsc          = cpu_rdtsc();
+    uint32_t h        = memprof_hash_addr(addr);
+    rec->next         = memprof_hash[h];
+    memprof_hash[h]   = rec;
+    local_intr_restore(intr_flag);
+    return;
+}
+
+void memprof_record_free(uint32_t type, ptr_t addr) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    memprof_record_t **link = &memprof_hash[memprof_hash_addr(addr)];
+    while (*link != NULL &&
+           ((*link)->addr != addr || (*link)->type != type)) {
+        link = &(*link)->next;
+    }
+    // 开启前的分配没有记录
+    memprof_record_t *rec = *link;
+    if (rec != NULL) {
+        *link                = rec->next;
+        memprof_site_t *site = memprof_site(type, rec->caller);
+        if (site != NULL) {
+            site->live--;
+            site->live_bytes -= rec->size;
+        }
+        rec->next         = memprof_free_list;
+        memprof_free_list = rec;
+    }
+    local_intr_restore(intr_flag);
+    return;
+}
+
+void memprof_dump(void) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    printk_info("memprof: %d sites, %d dropped\n", memprof_site_count,
+                memprof_dropped);
+    printk_info("caller      type allocs  total      live    live_bytes\n");
+    for (uint32_t i = 0; i < memprof_site_count; i++) {
+        memprof_site_t *site = &memprof_sites[i];
+        printk_info("0x%08X  %s %-7d %-10d %-7d %d\n", site->caller,
+                    site->type == MEMPROF_HEAP ? "heap" : "page", site->allocs,
+                    site->total_bytes, site->live, site->live_bytes);
+    }
+    local_intr_restore(intr_flag);
+    return;
+}
+
+// 若 value 是一个 kmalloc 记录的地址且未被标记，标记并加入待扫描栈
+static void memprof_mark(ptr_t value, uint32_t *top) {
+    memprof_record_t *rec = memprof_find(MEMPROF_HEAP, value);
+    if (rec == NULL) {
+        return;
+    }
+    uint32_t idx = rec - memprof_records;
+    if (memprof_marks[idx] == 0) {
+        memprof_marks[idx]      = 1;
+        memprof_stack[(*top)++] = idx;
+    }
+    return;
+}
+
+// 扫描 [start, end) 中的每个字
+static void memprof_scan(ptr_t start, ptr_t end, uint32_t *top) {
+    for (ptr_t p = (start + 3) & ~3; p + sizeof(ptr_t) <= end;
+         p += sizeof(ptr_t)) {
+        memprof_mark(*(ptr_t *)p, top);
+    }
+    return;
+}
+
+uint32_t memprof_leak_check(void) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    bzero(memprof_marks, sizeof(memprof_marks));
+    uint32_t top = 0;
+    // 根：内核数据段与 bss，跳过 memprof 自身的记录
+    // 内核栈位于数据段中，只扫描 esp 以上仍在使用的部分
+    ptr_t rec_start = (ptr_t)memprof_records;
+    ptr_t rec_end   = (ptr_t)(memprof_records + MEMPROF_RECORDS_MAX);
+    ptr_t esp       = 0;
+    __asm__ volatile("mov %%esp, %0" : "=r"(esp));
+    memprof_scan((ptr_t)KERNEL_DATA_START_ADDR, (ptr_t)STACK, &top);
+    memprof_scan(esp, rec_start, &top);
+    memprof_scan(rec_end, (ptr_t)KERNEL_END_ADDR, &top);
+    // 被引用的对象中的指针同样是引用
+    while (top > 0) {
+        memprof_record_t *rec = &memprof_records[memprof_stack[--top]];
+        if (rec->addr + rec->size <= VMM_DIRECT_MAP_END) {
+            memprof_scan(rec->addr, rec->addr + rec->size, &top);
+        }
+    }
+    uint32_t leaks = 0;
+    for (uint32_t h = 0; h < MEMPROF_HASH_SIZE; h++) {
+        for (memprof_record_t *rec = memprof_hash[h]; rec != NULL;
+             rec                   = rec->next) {
+            if (rec->type != MEMPROF_HEAP ||
+                memprof_marks[rec - memprof_records] != 0) {
+                continue;
+            }
+            leaks++;
+            printk_info("memprof: leak 0x%08X size %d caller 0x%08X tsc "
+                        "0x%016llX\n",
+                        rec->addr, rec->size, rec->caller, rec->tsc);
+        }
+    }
+    printk_info("memprof: %d leaks\n", leaks);
+    local_intr_restore(intr_flag);
+    return leaks;
+}
+
+#ifdef __cplusplus
+}
+#endif
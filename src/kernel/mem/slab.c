@@ -0,0 +1,348 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// slab.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "assert.h"
+#include "cpu.hpp"
+#include "sync.hpp"
+#include "pmm.h"
+#include "vmm.h"
+#include "slab.h"
+
+// 用于分配 kmem_cache_t 的 cache
+static kmem_cache_t cache_cache;
+// 所有 cache
+static kmem_cache_t *cache_chain;
+// 直接映射区中每个页所在 slab 的大小，0 表示不属于 slab，n 表示 2^(n-1) 页
+static uint8_t slab_page_order[VMM_DIRECT_MAP_END / PMM_PAGE_SIZE];
+
+// slab 中的空闲链表
+static inline uint16_t *slab_bufctl(slab_t *slab) {
+    return (uint16_t *)(slab + 1);
+}
+
+// slab 中下标为 idx 的对象
+static inline void *slab_obj(kmem_cache_t *cache, slab_t *slab,
+                             uint32_t idx) {
+    return (void *)((ptr_t)slab + cache->obj_offset + idx * cache->size);
+}
+
+// 对象在 slab 中的下标
+static inline uint32_t slab_obj_idx(kmem_cache_t *cache, slab_t *slab,
+                                    const void *obj) {
+    return ((ptr_t)obj - (ptr_t)slab - cache->obj_offset) / cache->size;
+}
+
+// 根据 slab 的使用情况找到其应在的链表
+static inline slab_t **slab_list(kmem_cache_t *cache, uint32_t inuse) {
+    if (inuse == 0) {
+        return &cache->slabs_empty;
+    }
+    else if (inuse == cache->num) {
+        return &cache->slabs_full;
+    }
+    return &cache->slabs_partial;
+}
+
+static inline void slab_list_add(slab_t **head, slab_t *slab) {
+    slab->prev = NULL;
+    slab->next = *head;
+    if (*head != NULL) {
+        (*head)->prev = slab;
+    }
+    *head = slab;
+    return;
+}
+
+static inline void slab_list_del(slab_t **head, slab_t *slab) {
+    if (slab->prev != NULL) {
+        slab->prev->next = slab->next;
+    }
+    else {
+        *head = slab->next;
+    }
+    if (slab->next != NULL) {
+        slab->next->prev = slab->prev;
+    }
+    return;
+}
+
+// 计算 slab 大小与每个 slab 中的对象数量
+static void cache_estimate(kmem_cache_t *cache) {
+    for (uint32_t pages = 1; pages <= SLAB_MAX_PAGES; pages <<= 1) {
+        uint32_t bytes = pages * PMM_PAGE_SIZE;
+        uint32_t num   = (bytes - sizeof(slab_t)) /
+                       (sizeof(uint16_t) + cache->size);
+        // 对象的对齐会占用额外空间
+        while (num > 0 && ((sizeof(slab_t) + num * sizeof(uint16_t) +
+                            cache->align - 1) &
+                           ~(cache->align - 1)) +
+                                  num * cache->size >
+                              bytes) {
+            num--;
+        }
+        cache->slab_pages = pages;
+        cache->num        = num;
+        cache->obj_offset =
+            (sizeof(slab_t) + num * sizeof(uint16_t) + cache->align - 1) &
+            ~(cache->align - 1);
+        // 浪费的空间不超过 1/8 即可
+        if (num > 0 && bytes - cache->obj_offset - num * cache->size <=
+                           bytes / 8) {
+            break;
+        }
+    }
+    return;
+}
+
+// 初始化 cache 的各项参数
+static void cache_setup(kmem_cache_t *cache, const char *name, size_t size,
+                        size_t align, void (*ctor)(void *obj)) {
+    bzero(cache, sizeof(kmem_cache_t));
+    if (align < SLAB_MIN_ALIGN) {
+        align = SLAB_MIN_ALIGN;
+    }
+    cache->name  = name;
+    cache->align = align;
+    cache->size  = (size + align - 1) & ~(align - 1);
+    cache->ctor  = ctor;
+    cache_estimate(cache);
+    return;
+}
+
+// 分配一个新的 slab 并构造其中的对象，调用前需关中断
+static slab_t *cache_grow(kmem_cache_t *cache) {
+    // 此时中断已关闭，pmm 在内存不足时报错后的 hlt 不会返回，先检查空闲页数
+    if (pmm_free_pages_count(NORMAL) < cache->slab_pages) {
+        return NULL;
+    }
+    // slab 按自身大小对齐，对象所在 slab 的起始地址可以直接计算
+    ptr_t pa =
+        pmm_alloc_page_align(cache->slab_pages, cache->slab_pages, NORMAL);
+    if (pa == (ptr_t)-1) {
+        return NULL;
+    }
+    slab_t *slab = (slab_t *)pa;
+    slab->magic  = SLAB_MAGIC;
+    slab->cache  = cache;
+    slab->inuse  = 0;
+    slab->free   = 0;
+    uint16_t *bufctl = slab_bufctl(slab);
+    for (uint32_t i = 0; i < cache->num; i++) {
+        bufctl[i] = (i + 1 < cache->num) ? i + 1 : SLAB_BUFCTL_END;
+        if (cache->ctor != NULL) {
+            cache->ctor(slab_obj(cache, slab, i));
+        }
+    }
+    uint8_t order = 1;
+    for (uint32_t pages = cache->slab_pages; pages > 1; pages >>= 1) {
+        order++;
+    }
+    for (uint32_t i = 0; i < cache->slab_pages; i++) {
+        slab_page_order[pa / PMM_PAGE_SIZE + i] = order;
+    }
+    slab_list_add(&cache->slabs_empty, slab);
+    cache->empty_count++;
+    cache->slab_count++;
+    return slab;
+}
+
+// 释放一个空 slab，调用前需关中断
+static void cache_slab_destroy(kmem_cache_t *cache, slab_t *slab) {
+    slab_list_del(&cache->slabs_empty, slab);
+    cache->empty_count--;
+    cache->slab_count--;
+    slab->magic = 0;
+    for (uint32_t i = 0; i < cache->slab_pages; i++) {
+        slab_page_order[(ptr_t)slab / PMM_PAGE_SIZE + i] = 0;
+    }
+    pmm_free_page((ptr_t)slab, cache->slab_pages, NORMAL);
+    return;
+}
+
+// 从 slab 中取出一个对象，调用前需关中断
+static void *cache_get_obj(kmem_cache_t *cache) {
+    slab_t *slab = cache->slabs_partial;
+    if (slab == NULL) {
+        slab = cache->slabs_empty;
+    }
+    if (slab == NULL) {
+        slab = cache_grow(cache);
+        if (slab == NULL) {
+            return NULL;
+        }
+    }
+    slab_list_del(slab_list(cache, slab->inuse), slab);
+    if (slab->inuse == 0) {
+        cache->empty_count--;
+    }
+    void *obj  = slab_obj(cache, slab, slab->free);
+    slab->free = slab_bufctl(slab)[slab->free];
+    slab->inuse++;
+    slab_list_add(slab_list(cache, slab->inuse), slab);
+    return obj;
+}
+
+// 将对象放回 slab，调用前需关中断
+static void cache_put_obj(kmem_cache_t *cache, void *obj) {
+    slab_t *slab = slab_get(obj);
+    if (slab == NULL || slab->cache != cache ||
+        (ptr_t)obj < (ptr_t)slab_obj(cache, slab, 0)) {
+        printk_err_nohalt("kmem_cache_free: Bad object 0x%08X in %s\n", obj,
+                          cache->name);
+        return;
+    }
+    uint32_t idx = slab_obj_idx(cache, slab, obj);
+    if (idx >= cache->num || slab_obj(cache, slab, idx) != obj) {
+        printk_err_nohalt("kmem_cache_free: Bad object 0x%08X in %s\n", obj,
+                          cache->name);
+        return;
+    }
+    slab_list_del(slab_list(cache, slab->inuse), slab);
+    slab_bufctl(slab)[idx] = slab->free;
+    slab->free             = idx;
+    slab->inuse--;
+    slab_list_add(slab_list(cache, slab->inuse), slab);
+    if (slab->inuse == 0) {
+        cache->empty_count++;
+        if (cache->empty_count > SLAB_EMPTY_MAX) {
+            cache_slab_destroy(cache, slab);
+        }
+    }
+    return;
+}
+
+// 将 CPU 缓存中的 n 个对象归还 slab，调用前需关中断
+static void magazine_drain(kmem_cache_t *cache, kmem_magazine_t *mag,
+                           uint32_t n) {
+    for (uint32_t i = 0; i < n && mag->avail > 0; i++) {
+        cache_put_obj(cache, mag->entries[--mag->avail]);
+    }
+    return;
+}
+
+void slab_init(void) {
+    bzero(slab_page_order, sizeof(slab_page_order));
+    cache_setup(&cache_cache, "kmem_cache", sizeof(kmem_cache_t), 0, NULL);
+    cache_chain = &cache_cache;
+    printk_info("slab_init\n");
+    return;
+}
+
+kmem_cache_t *kmem_cache_create(const char *name, size_t size, size_t align,
+                                void (*ctor)(void *obj)) {
+    // 对齐需为 2 的幂
+    if (size == 0 || (align & (align - 1)) != 0) {
+        return NULL;
+    }
+    kmem_cache_t *cache = kmem_cache_alloc(&cache_cache);
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache_setup(cache, name, size, align, ctor);
+    if (cache->num == 0) {
+        printk_err("kmem_cache_create: %s object too large\n", name);
+        kmem_cache_free(&cache_cache, cache);
+        return NULL;
+    }
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    cache->next = cache_chain;
+    cache_chain = cache;
+    local_intr_restore(intr_flag);
+    return cache;
+}
+
+void kmem_cache_destroy(kmem_cache_t *cache) {
+    kmem_cache_shrink(cache);
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    assert(cache->slab_count == 0, "kmem_cache_destroy: Objects in use.\n");
+    kmem_cache_t **link = &cache_chain;
+    while (*link != cache) {
+        link = &(*link)->next;
+    }
+    *link = cache->next;
+    local_intr_restore(intr_flag);
+    kmem_cache_free(&cache_cache, cache);
+    return;
+}
+
+void *kmem_cache_alloc(kmem_cache_t *cache) {
+    void *obj       = NULL;
+    bool  intr_flag = false;
+    local_intr_store(intr_flag);
+    kmem_magazine_t *mag = &cache->cpu[cpu_get_id()];
+    // 缓存为空时从 slab 中批量补充
+    if (mag->avail == 0) {
+        for (uint32_t i = 0; i < SLAB_MAGAZINE_BATCH; i++) {
+            void *tmp = cache_get_obj(cache);
+            if (tmp == NULL) {
+                break;
+            }
+            mag->entries[mag->avail++] = tmp;
+        }
+    }
+    if (mag->avail > 0) {
+        obj = mag->entries[--mag->avail];
+    }
+    local_intr_restore(intr_flag);
+    return obj;
+}
+
+void kmem_cache_free(kmem_cache_t *cache, void *obj) {
+    if (obj == NULL) {
+        return;
+    }
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    kmem_magazine_t *mag = &cache->cpu[cpu_get_id()];
+    // 缓存已满时批量归还 slab
+    if (mag->avail == SLAB_MAGAZINE_SIZE) {
+        magazine_drain(cache, mag, SLAB_MAGAZINE_BATCH);
+    }
+    mag->entries[mag->avail++] = obj;
+    local_intr_restore(intr_flag);
+    return;
+}
+
+void kmem_cache_shrink(kmem_cache_t *cache) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    for (uint32_t i = 0; i < CPU_MAX; i++) {
+        magazine_drain(cache, &cache->cpu[i], SLAB_MAGAZINE_SIZE);
+    }
+    while (cache->slabs_empty != NULL) {
+        cache_slab_destroy(cache, cache->slabs_empty);
+    }
+    local_intr_restore(intr_flag);
+    return;
+}
+
+slab_t *slab_get(const void *obj) {
+    ptr_t addr = (ptr_t)obj;
+    if (addr >= VMM_DIRECT_MAP_END) {
+        return NULL;
+    }
+    uint8_t order = slab_page_order[addr / PMM_PAGE_SIZE];
+    if (order == 0) {
+        return NULL;
+    }
+    slab_t *slab =
+        (slab_t *)(addr & ~((PMM_PAGE_SIZE << (order - 1)) - 1));
+    if (slab->magic != SLAB_MAGIC) {
+        return NULL;
+    }
+    return slab;
+}
+
+#ifdef __cplusplus
+}
+#endif
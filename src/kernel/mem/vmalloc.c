@@ -0,0 +1,411 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// vmalloc.c for Simple-XX/SimpleKernel.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "assert.h"
+#include "sync.hpp"
+#include "pmm.h"
+#include "vmm.h"
+#include "highmem.h"
+#include "slab.h"
+#include "vmalloc.h"
+
+// 区域描述符的 cache
+static kmem_cache_t *vm_area_cache;
+// 已占用的区域，按地址排序
+static vm_area_t *vm_area_list;
+// 延迟释放的页数
+static uint32_t vm_lazy_pages;
+// 统计信息
+static vmalloc_stat_t vm_stat;
+
+// 在 vmalloc 区中查找 size 字节、按 align 对齐的空闲虚拟地址并占用
+static vm_area_t *vm_area_reserve(size_t size, ptr_t align) {
+    ptr_t       addr = VMM_VMALLOC_START;
+    vm_area_t **link = &vm_area_list;
+    // 首次适应
+    while (*link != NULL) {
+        addr = (addr + align - 1) & ~(align - 1);
+        if (addr + size <= (*link)->addr) {
+            break;
+        }
+        addr = (*link)->addr + (*link)->size;
+        link = &(*link)->next;
+    }
+    addr = (addr + align - 1) & ~(align - 1);
+    if (addr + size > VMM_VMALLOC_END || addr + size < addr) {
+        return NULL;
+    }
+    vm_area_t *area = kmem_cache_alloc(vm_area_cache);
+    if (area == NULL) {
+        return NULL;
+    }
+    area->addr  = addr;
+    area->size  = size;
+    area->flags = 0;
+    area->next  = *link;
+    *link       = area;
+    return area;
+}
+
+// 回收虚拟地址
+static void vm_area_release(vm_area_t *area) {
+    vm_area_t **link = &vm_area_list;
+    while (*link != area) {
+        link = &(*link)->next;
+    }
+    *link = area->next;
+    kmem_cache_free(vm_area_cache, area);
+    return;
+}
+
+// 查找以 addr 开始的区域
+static vm_area_t *vm_area_find(ptr_t addr) {
+    for (vm_area_t *area = vm_area_list; area != NULL; area = area->next) {
+        if (area->addr == addr) {
+            return area;
+        }
+    }
+    return NULL;
+}
+
+// 分配一个物理页，优先使用 HIGHMEM，为直接映射区节省内存
+static ptr_t vmalloc_alloc_frame(void) {
+    int8_t zone = (pmm_free_pages_count(HIGHMEM) > 0) ? HIGHMEM : NORMAL;
+    return pmm_alloc_page(1, zone);
+}
+
+// 刷新 TLB 并回收所有延迟释放的区域，调用前需关中断
+static void vmalloc_purge_locked(void) {
+    if (vm_lazy_pages == 0) {
+        return;
+    }
+    // 一次刷新所有已解除映射的页
+    vmm_tlb_flush();
+    vm_area_t *area = vm_area_list;
+    while (area != NULL) {
+        vm_area_t *next = area->next;
+        if (area->flags & VM_LAZY_FREE) {
+            vm_area_release(area);
+        }
+        area = next;
+    }
+    vm_lazy_pages = 0;
+    return;
+}
+
+void vmalloc_init(void) {
+    vm_area_cache = kmem_cache_create("vm_area", sizeof(vm_area_t), 0, NULL);
+    assert(vm_area_cache != NULL, "vmalloc_init: No enough phy mem.\n");
+    vm_area_list  = NULL;
+    vm_lazy_pages = 0;
+    bzero(&vm_stat, sizeof(vm_stat));
+    printk_info("vmalloc_init\n");
+    return;
+}
+
+// 分配虚拟地址按 align 对齐的区域并映射物理页
+static void *vmalloc_area(size_t size, ptr_t align, uint32_t flags) {
+    // 超过 vmalloc 区大小的请求不可能满足，也避免页对齐时溢出
+    if (size == 0 || size > VMM_VMALLOC_END - VMM_VMALLOC_START) {
+        return NULL;
+    }
+    uint32_t pages     = VMM_PAGE_ALIGN(size) / VMM_PAGE_SIZE;
+    bool     intr_flag = false;
+    local_intr_store(intr_flag);
+    // 末尾多占用一页作为保护页，不做映射
+    vm_area_t *area = vm_area_reserve((pages + 1) * VMM_PAGE_SIZE, align);
+    // 虚拟地址不足时先回收延迟释放的区域
+    if (area == NULL && vm_lazy_pages != 0) {
+        vmalloc_purge_locked();
+        area = vm_area_reserve((pages + 1) * VMM_PAGE_SIZE, align);
+    }
+    if (area != NULL) {
+        area->flags = VM_ALLOC | flags;
+    }
+    local_intr_restore(intr_flag);
+    if (area == NULL) {
+        printk_err("vmalloc: No enough virtual address space.\n");
+        return NULL;
+    }
+    for (uint32_t i = 0; i < pages; i++) {
+        ptr_t va = area->addr + i * VMM_PAGE_SIZE;
+        ptr_t pa = vmalloc_alloc_frame();
+        if (pa == (ptr_t)-1) {
+            vfree((void *)area->addr);
+            return NULL;
+        }
+        if (vmm_map(pgd_kernel, va, pa, VMM_PAGE_KERNEL) == false) {
+            pmm_free_page(pa, 1, mem_page[pa / PMM_PAGE_SIZE].zone);
+            vfree((void *)area->addr);
+            return NULL;
+        }
+    }
+    return (void *)area->addr;
+}
+
+void *vmalloc(size_t size) {
+    return vmalloc_area(size, VMM_PAGE_SIZE, 0);
+}
+
+void *vmalloc_huge(size_t size) {
+    return vmalloc_area(size, VMM_LARGE_PAGE_SIZE, VM_HUGE);
+}
+
+bool vmalloc_set_huge(void *addr, bool enable) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    vm_area_t *area = vm_area_find((ptr_t)addr);
+    // ioremap 的区域映射的是设备内存，不能合并
+    bool res = area != NULL && (area->flags & VM_ALLOC) &&
+               (area->flags & VM_LAZY_FREE) == 0;
+    if (res == true) {
+        if (enable == true) {
+            area->flags |= VM_HUGE;
+        }
+        else {
+            area->flags &= ~VM_HUGE;
+        }
+    }
+    local_intr_restore(intr_flag);
+    return res;
+}
+
+// 区域是否可以合并为大页
+static bool vmalloc_can_collapse(const vm_area_t *area) {
+    return (area->flags & VM_ALLOC) && (area->flags & VM_HUGE) &&
+           (area->flags & VM_LAZY_FREE) == 0;
+}
+
+// va 开始的 4MB 是否已全部映射为普通页，调用前需关中断
+static bool vmalloc_collapsible(ptr_t va) {
+    pgd_t pde = pgd_kernel[VMM_PGD_INDEX(va)];
+    if ((pde & VMM_PAGE_PRESENT) == 0 || (pde & VMM_PAGE_LARGE)) {
+        return false;
+    }
+    pte_t *pte = VMM_RECURSIVE_PTE(va);
+    for (uint32_t i = 0; i < VMM_ENTRIES_PER_TABLE; i++) {
+        if ((pte[i] & VMM_PAGE_PRESENT) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 查找一个可以合并的 4MB 区间，调用前需关中断
+static vm_area_t *vmalloc_collapse_find(ptr_t *va_out) {
+    for (vm_area_t *area = vm_area_list; area != NULL; area = area->next) {
+        if (vmalloc_can_collapse(area) == false) {
+            continue;
+        }
+        // 不包含末尾的保护页
+        ptr_t end = area->addr + area->size - VMM_PAGE_SIZE;
+        ptr_t va  = (area->addr + VMM_LARGE_PAGE_SIZE - 1) &
+                   VMM_LARGE_PAGE_MASK;
+        for (; va + VMM_LARGE_PAGE_SIZE <= end; va += VMM_LARGE_PAGE_SIZE) {
+            if (vmalloc_collapsible(va) == true) {
+                *va_out = va;
+                return area;
+            }
+        }
+    }
+    return NULL;
+}
+
+// 分配一个 4MB 对齐的大页，优先使用 HIGHMEM
+// 先检查空闲页数，避免 pmm 在内存不足时报错
+static ptr_t vmalloc_alloc_large_frame(void) {
+    uint32_t pages = VMM_LARGE_PAGE_SIZE / VMM_PAGE_SIZE;
+    ptr_t    frame = (ptr_t)-1;
+    if (pmm_free_pages_count(HIGHMEM) >= pages) {
+        frame = pmm_alloc_page_align(pages, pages, HIGHMEM);
+    }
+    if (frame == (ptr_t)-1 && pmm_free_pages_count(NORMAL) >= pages) {
+        frame = pmm_alloc_page_align(pages, pages, NORMAL);
+    }
+    return frame;
+}
+
+// 将 va 开始的 4MB 复制到大页 frame 中，调用前需关中断
+static void vmalloc_collapse_one(ptr_t va, ptr_t frame) {
+    pte_t *pte = VMM_RECURSIVE_PTE(va);
+    // 复制并归还原来的物理页
+    for (uint32_t i = 0; i < VMM_ENTRIES_PER_TABLE; i++) {
+        void *dst = kmap_atomic(frame + i * VMM_PAGE_SIZE);
+        memcpy(dst, (void *)(va + i * VMM_PAGE_SIZE), VMM_PAGE_SIZE);
+        kunmap_atomic(dst);
+        ptr_t pa = pte[i] & VMM_PAGE_MASK;
+        pmm_free_page(pa, 1, mem_page[pa / PMM_PAGE_SIZE].zone);
+    }
+    vmm_map_large(pgd_kernel, va, frame, VMM_PAGE_KERNEL);
+    vm_stat.collapse_success++;
+    vm_stat.large_pages++;
+    return;
+}
+
+bool vmalloc_collapse(void) {
+    if (vmm_has_large_page() == false) {
+        return false;
+    }
+    bool  intr_flag = false;
+    ptr_t va        = 0;
+    local_intr_store(intr_flag);
+    vm_area_t *area = vmalloc_collapse_find(&va);
+    ptr_t      addr = area != NULL ? area->addr : 0;
+    local_intr_restore(intr_flag);
+    if (area == NULL) {
+        return false;
+    }
+    // 分配物理内存时不关中断，pmm 报错后的 hlt 不会使机器停止
+    ptr_t frame = vmalloc_alloc_large_frame();
+    bool  res   = false;
+    // 复制期间不能有其它写入
+    local_intr_store(intr_flag);
+    vm_stat.collapse_scan++;
+    // 分配期间区域可能已被释放或改变
+    area = vm_area_find(addr);
+    if (area != NULL && vmalloc_can_collapse(area) == true) {
+        if (frame == (ptr_t)-1) {
+            // 没有对齐的物理内存，不再尝试合并该区域，
+            // 之后可以通过 vmalloc_set_huge() 重新允许
+            area->flags &= ~VM_HUGE;
+            vm_stat.collapse_fail++;
+        }
+        else if (vmalloc_collapsible(va) == true) {
+            vmalloc_collapse_one(va, frame);
+            res = true;
+        }
+    }
+    local_intr_restore(intr_flag);
+    if (frame != (ptr_t)-1 && res == false) {
+        pmm_free_page(frame, VMM_LARGE_PAGE_SIZE / VMM_PAGE_SIZE,
+                      mem_page[frame / PMM_PAGE_SIZE].zone);
+    }
+    return res;
+}
+
+void vmalloc_get_stat(vmalloc_stat_t *stat) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    *stat = vm_stat;
+    local_intr_restore(intr_flag);
+    return;
+}
+
+void vfree(void *addr) {
+    if (addr == NULL) {
+        return;
+    }
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    vm_area_t *area = vm_area_find((ptr_t)addr);
+    if (area == NULL || (area->flags & VM_LAZY_FREE)) {
+        local_intr_restore(intr_flag);
+        printk_err("vfree: Bad address 0x%08X\n", addr);
+        return;
+    }
+    // 解除映射并归还物理页，TLB 只记录不刷新
+    uint32_t pages = area->size / VMM_PAGE_SIZE - 1;
+    for (uint32_t i = 0; i < pages; i++) {
+        ptr_t va = area->addr + i * VMM_PAGE_SIZE;
+        ptr_t pa = 0;
+        if (vmm_get_mapping(pgd_kernel, va, &pa) == false) {
+            continue;
+        }
+        // 已被合并为大页，整体释放
+        if (pgd_kernel[VMM_PGD_INDEX(va)] & VMM_PAGE_LARGE) {
+            vmm_unmap(pgd_kernel, va);
+            if (area->flags & VM_ALLOC) {
+                pmm_free_page(pa & VMM_LARGE_PAGE_MASK,
+                              VMM_LARGE_PAGE_SIZE / VMM_PAGE_SIZE,
+                              mem_page[pa / PMM_PAGE_SIZE].zone);
+                vm_stat.large_pages--;
+            }
+            i += VMM_ENTRIES_PER_TABLE - 1;
+            continue;
+        }
+        vmm_unmap(pgd_kernel, va);
+        if (area->flags & VM_ALLOC) {
+            pmm_free_page(pa & VMM_PAGE_MASK, 1,
+                          mem_page[pa / PMM_PAGE_SIZE].zone);
+        }
+    }
+    // 在 TLB 刷新前该段虚拟地址不能被重用
+    area->flags |= VM_LAZY_FREE;
+    vm_lazy_pages += pages;
+    if (vm_lazy_pages > VMALLOC_LAZY_MAX_PAGES) {
+        vmalloc_purge_locked();
+    }
+    local_intr_restore(intr_flag);
+    return;
+}
+
+void vmalloc_purge(void) {
+    bool intr_flag = false;
+    local_intr_store(intr_flag);
+    vmalloc_purge_locked();
+    local_intr_restore(intr_flag);
+    return;
+}
+
+// 映射设备内存，返回值包含 pa 在页内的偏移
+static void *ioremap_flags(ptr_t pa, size_t size, uint32_t flags) {
+    // 区域可以恰好结束于 4GB，pa + size 此时为 0
+    // 超过 vmalloc 区大小的请求不可能满足，也避免下面页数的计算溢出
+    if (size == 0 || size - 1 > ~pa ||
+        size > VMM_VMALLOC_END - VMM_VMALLOC_START) {
+        return NULL;
+    }
+    ptr_t    offset    = pa & ~VMM_PAGE_MASK;
+    uint32_t pages     = VMM_PAGE_ALIGN(offset + size) / VMM_PAGE_SIZE;
+    bool     intr_flag = false;
+    local_intr_store(intr_flag);
+    vm_area_t *area = vm_area_reserve((pages + 1) * VMM_PAGE_SIZE,
+                                      VMM_PAGE_SIZE);
+    if (area == NULL && vm_lazy_pages != 0) {
+        vmalloc_purge_locked();
+        area = vm_area_reserve((pages + 1) * VMM_PAGE_SIZE, VMM_PAGE_SIZE);
+    }
+    local_intr_restore(intr_flag);
+    if (area == NULL) {
+        printk_err("ioremap: No enough virtual address space.\n");
+        return NULL;
+    }
+    // 没有 VM_ALLOC 标志，vfree 时不会归还物理页
+    pa &= VMM_PAGE_MASK;
+    for (uint32_t i = 0; i < pages; i++) {
+        if (vmm_map(pgd_kernel, area->addr + i * VMM_PAGE_SIZE,
+                    pa + i * VMM_PAGE_SIZE, flags) == false) {
+            vfree((void *)area->addr);
+            return NULL;
+        }
+    }
+    return (void *)(area->addr + offset);
+}
+
+void *ioremap(ptr_t pa, size_t size) {
+    // PCD | PWT 为强不可缓存，寄存器访问不会被合并或重排
+    return ioremap_flags(pa, size,
+                         VMM_PAGE_KERNEL | VMM_PAGE_PCD | VMM_PAGE_PWT);
+}
+
+void *ioremap_wc(ptr_t pa, size_t size) {
+    // 只设置 PCD 时由 MTRR 决定最终类型，MTRR 为 WC 时写操作可以合并
+    return ioremap_flags(pa, size, VMM_PAGE_KERNEL | VMM_PAGE_PCD);
+}
+
+void iounmap(void *addr) {
+    vfree((void *)((ptr_t)addr & VMM_PAGE_MASK));
+    return;
+}
+
+#ifdef __cplusplus
+}
+#endif
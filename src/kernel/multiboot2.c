@@ -10,6 +10,7 @@ extern "C" {
 
 #include "stdio.h"
 #include "debug.h"
+#include "string.h"
 #include "multiboot2.h"
 
 void print_MULTIBOOT_TAG_TYPE_CMDLINE(multiboot_tag_t *tag) {
@@ -49,6 +50,9 @@ void print_MULTIBOOT_TAG_TYPE_BOOTDEV(multiboot_tag_t *tag) {
 
 multiboot_memory_map_entry_t *mmap_entries;
 multiboot_mmap_tag_t *        mmap_tag;
+const char *                  multiboot2_cmdline;
+
+struct multiboot_tag_framebuffer *multiboot2_framebuffer;
 
 void print_MULTIBOOT_TAG_TYPE_MMAP(multiboot_tag_t *tag) {
     mmap_entries = ((struct multiboot_tag_mmap *)tag)->entries;
@@ -61,12 +65,8 @@ void print_MULTIBOOT_TAG_TYPE_MMAP(multiboot_tag_t *tag) {
          mmap = (multiboot_memory_map_entry_t
                      *)((uint32_t)mmap +
                         ((struct multiboot_tag_mmap *)tag)->entry_size)) {
-        printk_info("base_addr = 0x%X%X, length = 0x%X%X, type = 0x%X\n",
-                    (unsigned)(mmap->addr >> 32),        // high
-                    (unsigned)(mmap->addr & 0xffffffff), // low
-                    (unsigned)(mmap->len >> 32),         // high
-                    (unsigned)(mmap->len & 0xffffffff),  // low
-                    (unsigned)mmap->type);
+        printk_info("base_addr = 0x%llX, length = 0x%llX, type = 0x%X\n",
+                    mmap->addr, mmap->len, (unsigned)mmap->type);
     }
 #endif
     return;
@@ -125,6 +125,27 @@ bool is_multiboot2_header(ptr_t magic, ptr_t addr) {
     return true;
 }
 
+bool multiboot2_cmdline_has(const char *opt) {
+    if (multiboot2_cmdline == NULL) {
+        return false;
+    }
+    // 以空格分隔的选项
+    size_t      len = strlen(opt);
+    const char *p   = multiboot2_cmdline;
+    while (p != NULL) {
+        while (*p == ' ') {
+            p++;
+        }
+        const char *end = strchr(p, ' ');
+        size_t      n   = (end != NULL) ? (size_t)(end - p) : strlen(p);
+        if (n == len && strncmp(p, opt, len) == 0) {
+            return true;
+        }
+        p = end;
+    }
+    return false;
+}
+
 // 处理 multiboot 信息
 void multiboot2_init(ptr_t magic, ptr_t addr) {
     // Am I booted by a Multiboot-compliant boot loader?
@@ -144,6 +165,8 @@ void multiboot2_init(ptr_t magic, ptr_t addr) {
         switch (tag->type) {
             case MULTIBOOT_TAG_TYPE_CMDLINE:
                 // print_MULTIBOOT_TAG_TYPE_CMDLINE(tag);
+                multiboot2_cmdline =
+                    ((struct multiboot_tag_string *)tag)->string;
                 break;
             case MULTIBOOT_TAG_TYPE_BOOT_LOADER_NAME:
                 // print_MULTIBOOT_TAG_TYPE_BOOT_LOADER_NAME(tag);
@@ -160,6 +183,10 @@ void multiboot2_init(ptr_t magic, ptr_t addr) {
             case MULTIBOOT_TAG_TYPE_MMAP:
                 print_MULTIBOOT_TAG_TYPE_MMAP(tag);
                 break;
+            case MULTIBOOT_TAG_TYPE_FRAMEBUFFER:
+                multiboot2_framebuffer =
+                    (struct multiboot_tag_framebuffer *)tag;
+                break;
             case MULTIBOOT_TAG_TYPE_ELF_SECTIONS: {
                 // print_MULTIBOOT_TAG_TYPE_ELF_SECTIONS(tag);
                 // printk("!!!!!!!!!!!!!!!!!!!\n");
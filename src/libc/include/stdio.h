@@ -12,7 +12,33 @@ extern "C" {
 #endif
 
 #include "stdint.h"
+#include "stdarg.h"
 
+#include "stddef.h"
+
+// vsprintf 的缓冲区大小上限
+#define PRINTF_SIZE_MAX (0x7FFFFFFF)
+// 格式化时暂存短片段的缓冲区大小
+#define PRINTF_STAGE_SIZE (64)
+
+// 格式化输出的目标，格式化引擎边格式化边将字符写入 sink
+// 可嵌入更大的结构体中携带其它状态
+typedef struct printf_sink {
+    // 输出 str 开始的 len 个字符
+    void (*printf_sink_write)(struct printf_sink *sink, const char *str,
+                              size_t len);
+} printf_sink_t;
+
+// 格式化输出到 sink，返回输出的字符数
+// 整数支持 hh、h、l、ll、z、j、t 长度修饰符
+int32_t vprintf_sink(printf_sink_t *sink, const char *fmt, va_list args);
+// 格式化输出到 buf，最多写入 size 个字节（含 '\0'）
+// 返回完整输出所需的字符数
+int32_t vsnprintf(char *buf, size_t size, const char *fmt, va_list args);
+int32_t snprintf(char *buf, size_t size, const char *fmt, ...);
+int32_t vsprintf(char *buf, const char *fmt, va_list args);
+int32_t sprintf(char *buf, const char *fmt, ...);
+int32_t vprintk(const char *fmt, va_list args);
 int32_t printk(const char *fmt, ...);
 int32_t printk_color(unsigned char color, const char *format, ...);
 int32_t printf(const char *fmt, ...);
@@ -20,6 +46,9 @@ int32_t printk_info(const char *fmt, ...);
 int32_t printk_debug(const char *fmt, ...);
 int32_t printk_test(const char *fmt, ...);
 int32_t printk_err(const char *fmt, ...);
+// 与 printk_err 相同但不停机，用于可恢复的错误
+// printk_err 的 hlt 在关中断时（如 cpu_sti 之前）不会返回
+int32_t printk_err_nohalt(const char *fmt, ...);
 
 // 枚举颜色，与 vga_color 相同
 enum color {
@@ -46,6 +75,52 @@ enum color {
 #define COL_INFO light_green
 #define COL_TEST green
 
+// 日志级别，数值越小越重要
+#define KLOG_ERR (0)
+#define KLOG_INFO (1)
+#define KLOG_TEST (2)
+#define KLOG_DEBUG (3)
+#define KLOG_LEVEL_MAX (4)
+// 不输出任何日志
+#define KLOG_OFF (-1)
+
+// 编译时的日志级别，级别更高的 printk_info、printk_test、printk_debug
+// 调用连同参数一起被去掉，由 src/CMakeLists.txt 按构建类型设置
+#ifndef KLOG_LEVEL_COMPILE
+#define KLOG_LEVEL_COMPILE KLOG_DEBUG
+#endif
+
+// 日志所属的子系统，由各目录的 CMakeLists.txt 定义 KLOG_SYS 指定
+#define KLOG_SYS_KERNEL (0)
+#define KLOG_SYS_MM (1)
+#define KLOG_SYS_ARCH (2)
+#define KLOG_SYS_DRV (3)
+#define KLOG_SYS_TEST (4)
+#define KLOG_SYS_MAX (5)
+#ifndef KLOG_SYS
+#define KLOG_SYS KLOG_SYS_KERNEL
+#endif
+
+// 运行时过滤，klog_mask[level] 的第 sys 位为 1 时子系统 sys 输出该级别的日志
+extern uint32_t klog_mask[KLOG_LEVEL_MAX];
+
+#define KLOG_ENABLED(level, sys)                                               \
+    ((level) <= KLOG_LEVEL_COMPILE && (klog_mask[(level)] & (1U << (sys))) != 0)
+
+// 先检查级别与子系统的位，不输出时既不计算参数也不格式化
+#define KLOG_CALL(level, fn, ...)                                              \
+    ({                                                                         \
+        int32_t _klog_res = 0;                                                 \
+        if (KLOG_ENABLED(level, KLOG_SYS)) {                                   \
+            _klog_res = (fn)(__VA_ARGS__);                                     \
+        }                                                                      \
+        _klog_res;                                                             \
+    })
+
+#define printk_info(...) KLOG_CALL(KLOG_INFO, printk_info, __VA_ARGS__)
+#define printk_test(...) KLOG_CALL(KLOG_TEST, printk_test, __VA_ARGS__)
+#define printk_debug(...) KLOG_CALL(KLOG_DEBUG, printk_debug, __VA_ARGS__)
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,18 +13,47 @@ extern "C" {
 
 #include "stdint.h"
 #include "stddef.h"
+#include "stdbool.h"
 
-extern void memcpy(void *dest, void *src, uint32_t len);
-extern void memset(void *dest, uint8_t val, uint32_t len);
-extern void bzero(void *dest, uint32_t len);
+// 小于该长度的 memcpy/memset 使用展开的 32 位循环
+#define STRING_SMALL_SIZE (64)
+
+// 体系结构提供的 SIMD 实现，长度不小于 threshold 时使用
+// 每个函数返回已处理的字节数，剩余部分由普通实现完成
+// 返回 0 表示当前不能使用 SIMD
+typedef struct string_simd {
+    // 使用 SIMD 实现的最小长度
+    size_t threshold;
+    size_t (*string_simd_memcpy)(void *dest, const void *src, size_t len);
+    size_t (*string_simd_memset)(void *dest, int val, size_t len);
+    // 返回的长度之前的内容都相等
+    size_t (*string_simd_memcmp)(const void *src1, const void *src2,
+                                 size_t len);
+} string_simd_t;
+
+// 选择 memcpy/memset 的实现，erms 为 CPU 是否支持 ERMS
+// 初始化前使用 rep movsd/stosd 实现
+extern void string_init(bool erms);
+// 设置 SIMD 实现，为 NULL 时不使用
+extern void  string_set_simd(const string_simd_t *simd);
+extern void *memcpy(void *dest, const void *src, size_t len);
+// 允许重叠的复制
+extern void *memmove(void *dest, const void *src, size_t len);
+extern void *memset(void *dest, int val, size_t len);
+extern void  bzero(void *dest, size_t len);
+extern int   memcmp(const void *src1, const void *src2, size_t len);
+extern void *memchr(const void *src, int c, size_t len);
 // 字符串比较
-extern int8_t strcmp(const char *src, const char *dest);
-extern char * strcpy(char *dest, const char *src);
-extern char * strncpy(char *dest, const char *src, uint32_t len);
+extern int   strcmp(const char *src, const char *dest);
+extern int   strncmp(const char *src, const char *dest, size_t len);
+extern char *strcpy(char *dest, const char *src);
+extern char *strncpy(char *dest, const char *src, size_t len);
 // 字符串合并
 extern char *strcat(char *dest, const char *src);
+extern char *strchr(const char *str, int c);
 // length of string
 extern size_t strlen(const char *src);
+extern size_t strnlen(const char *src, size_t maxlen);
 extern void   backspace(char *src);
 extern void   append(char *src, char dest);
 
@@ -1,4 +1,3 @@
-
 // This file is a part of Simple-XX/SimpleKernel
 // (https://github.com/Simple-XX/SimpleKernel).
 //
@@ -12,22 +11,23 @@ extern "C" {
 #include "stdarg.h"
 #include "stdint.h"
 #include "string.h"
+#include "klog.h"
 
-static char buf[1024];
-
-extern int           vsprintf(char *buf, const char *fmt, va_list args);
-extern void          console_writestring(const char *data);
-extern void          console_setcolor(unsigned char color);
 extern unsigned char console_getcolor(void);
+extern bool          console_set_deferred(bool deferred);
+extern bool          serial_set_polled(bool polled);
+
+// 格式化结果写入日志缓冲区，由 klog_flush 输出到控制台与串口
+int32_t vprintk(const char *fmt, va_list args) {
+    return klog_vwrite(KLOG_INFO, 0, console_getcolor(), fmt, args);
+}
 
 int32_t printk(const char *fmt, ...) {
     va_list args;
     int     i;
     va_start(args, fmt);
-    i = vsprintf(buf, fmt, args);
+    i = vprintk(fmt, args);
     va_end(args);
-    console_writestring(buf);
-    bzero(buf, 1024);
     return i;
 }
 
@@ -35,68 +35,72 @@ int32_t printk_color(uint8_t color, const char *fmt, ...) {
     va_list args;
     int     i;
     va_start(args, fmt);
-    i = vsprintf(buf, fmt, args);
+    i = klog_vwrite(KLOG_INFO, 0, color, fmt, args);
     va_end(args);
-    unsigned char old_color = console_getcolor();
-    console_setcolor(color);
-    console_writestring(buf);
-    console_setcolor(old_color);
-    bzero(buf, 1024);
     return i;
 }
 
-// TODO:
-// 将一下几个函数精简成调用 printk() 的形式，注意参数传递方式
-
-int32_t printk_info(const char *fmt, ...) {
-    printk_color(COL_INFO, "[INFO] ");
+// 名称加括号，避免被 stdio.h 中的同名宏展开
+int32_t(printk_info)(const char *fmt, ...) {
     va_list args;
     int     i;
     va_start(args, fmt);
-    i = vsprintf(buf, fmt, args);
+    i = klog_vwrite(KLOG_INFO, KLOG_PREFIX, console_getcolor(), fmt, args);
     va_end(args);
-    console_writestring(buf);
-    bzero(buf, 1024);
     return i;
 }
 
-int32_t printk_debug(const char *fmt, ...) {
-    printk_color(COL_DEBUG, "[DEBUG] ");
+int32_t(printk_debug)(const char *fmt, ...) {
     va_list args;
     int     i;
     va_start(args, fmt);
-    i = vsprintf(buf, fmt, args);
+    i = klog_vwrite(KLOG_DEBUG, KLOG_PREFIX, console_getcolor(), fmt, args);
     va_end(args);
-    console_writestring(buf);
-    bzero(buf, 1024);
     return i;
 }
 
-int32_t printk_test(const char *fmt, ...) {
-    printk_color(COL_TEST, "[TEST] ");
+int32_t(printk_test)(const char *fmt, ...) {
     va_list args;
     int     i;
     va_start(args, fmt);
-    i = vsprintf(buf, fmt, args);
+    i = klog_vwrite(KLOG_TEST, KLOG_PREFIX, console_getcolor(), fmt, args);
     va_end(args);
-    console_writestring(buf);
-    bzero(buf, 1024);
+    return i;
+}
+
+// 错误信息立即写出，之后恢复原来的设置，可恢复的错误不影响之后的输出
+// panic 与 CPU 异常由 debug_emergency 切换为同步输出
+static int32_t vprintk_err(const char *fmt, va_list args) {
+    bool    klog_deferred    = klog_set_deferred(false);
+    bool    console_deferred = console_set_deferred(false);
+    bool    serial_polled    = serial_set_polled(true);
+    int32_t i =
+        klog_vwrite(KLOG_ERR, KLOG_PREFIX, console_getcolor(), fmt, args);
+    serial_set_polled(serial_polled);
+    console_set_deferred(console_deferred);
+    klog_set_deferred(klog_deferred);
     return i;
 }
 
 int printk_err(const char *fmt, ...) {
-    printk_color(COL_ERROR, "[ERROR] ");
     va_list args;
     int     i;
     va_start(args, fmt);
-    i = vsprintf(buf, fmt, args);
+    i = vprintk_err(fmt, args);
     va_end(args);
-    console_writestring(buf);
-    bzero(buf, 1024);
     asm("hlt");
     return i;
 }
 
+int32_t printk_err_nohalt(const char *fmt, ...) {
+    va_list args;
+    int     i;
+    va_start(args, fmt);
+    i = vprintk_err(fmt, args);
+    va_end(args);
+    return i;
+}
+
 #ifdef __cplusplus
 }
 #endif
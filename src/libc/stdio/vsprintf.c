@@ -14,8 +14,8 @@ extern "C" {
 #include "stdarg.h"
 #include "stddef.h"
 #include "stdint.h"
-
-extern size_t strlen(const char *str);
+#include "string.h"
+#include "stdio.h"
 
 // 判断字符是否数字字符
 #define is_digit(c) ((c) >= '0' && (c) <= '9')
@@ -45,21 +45,155 @@ static int skip_atoi(const char **s) {
 // use 'abcdef' instead of 'ABCDEF'  使用小写字母
 #define SMALL 64
 
-// 除操作。n 被除数；base 除数。结果 n 为商，函数返回值为余数。
-#define do_div(n, base)                                                        \
-    ({                                                                         \
-        int __res;                                                             \
-        __asm__("divl %4" : "=a"(n), "=d"(__res) : "0"(n), "1"(0), "r"(base)); \
-        __res;                                                                 \
-    })
+// 64 位除以 32 位。n 被除数；base 除数。结果 n 为商，函数返回值为余数。
+// 只使用 divl，不依赖 libgcc 的 64 位除法
+static inline uint32_t do_div(uint64_t *n, uint32_t base) {
+    uint32_t high = *n >> 32;
+    uint32_t low  = (uint32_t)*n;
+    uint32_t qh   = 0;
+    uint32_t rem;
+    if (high >= base) {
+        qh = high / base;
+        high %= base;
+    }
+    __asm__("divl %4" : "=a"(low), "=d"(rem) : "0"(low), "1"(high), "r"(base));
+    *n = ((uint64_t)qh << 32) | low;
+    return rem;
+}
+
+// 两位十进制数字表，"00" 到 "99"
+static const char digit_pairs[201] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+// 将 32 位数 n 转换为十进制，从 end 向前存放，不足 min 位时补 0
+// 返回第一个数字的位置
+// 每次除以 100 得到两位数字，除法用乘以倒数代替：n / 100 == n * 0x51EB851F >> 37
+static char *number_dec(char *end, uint32_t n, int min) {
+    char *p = end;
+    while (n >= 100) {
+        uint32_t q = ((uint64_t)n * 0x51EB851FUL) >> 37;
+        uint32_t r = (n - q * 100) * 2;
+        *--p       = digit_pairs[r + 1];
+        *--p       = digit_pairs[r];
+        n          = q;
+    }
+    if (n >= 10) {
+        *--p = digit_pairs[n * 2 + 1];
+        *--p = digit_pairs[n * 2];
+    }
+    else if (n != 0 || p == end) {
+        *--p = '0' + n;
+    }
+    while (end - p < min) {
+        *--p = '0';
+    }
+    return p;
+}
+
+// 将 num 转换为 base 进制的数字，从 end 向前存放，返回第一个数字的位置
+static char *number_digits(char *end, uint64_t num, int base,
+                           const char *digits) {
+    char *p = end;
+    if (num == 0) {
+        *--p = '0';
+    }
+    // 2 的幂进制只需移位，32 位以内的数使用 32 位移位
+    else if ((base & (base - 1)) == 0) {
+        int      shift = __builtin_ctz(base);
+        uint32_t mask  = base - 1;
+        while (num > 0xFFFFFFFFUL) {
+            *--p = digits[(uint32_t)num & mask];
+            num >>= shift;
+        }
+        for (uint32_t n = num; n != 0; n >>= shift) {
+            *--p = digits[n & mask];
+        }
+    }
+    // 十进制每次除以 10^8，余数按两位一组转换，64 位数最多除两次
+    else if (base == 10) {
+        while (num > 0xFFFFFFFFUL) {
+            p = number_dec(p, do_div(&num, 100000000), 8);
+        }
+        p = number_dec(p, (uint32_t)num, 0);
+    }
+    else {
+        while (num != 0) {
+            *--p = digits[do_div(&num, base)];
+        }
+    }
+    return p;
+}
+
+// 格式化过程中的输出状态
+// 字符先写入 buf，满了或结束时整段交给 sink，减少 sink 的调用次数
+// 输出到字符串时 buf 即目标缓冲区，sink 为 NULL，超出部分只计数不写入
+typedef struct printf_out {
+    printf_sink_t *sink;
+    char *         buf;
+    size_t         size;
+    // buf 中的字符数
+    size_t len;
+    // 已输出的字符数
+    int32_t count;
+} printf_out_t;
 
-// 将整数转换为指定进制的字符串。输入：num-整数；base-进制；size-字符串长度;precision-数字长度
-// (精读)；type-类型选项。输出：str-字符串指针
-static char *number(char *str, int num, int base, int size, int precision,
-                    int type) {
-    char        c, sign, tmp[36];
+// 将 buf 中的字符交给 sink
+static void out_flush(printf_out_t *o) {
+    if (o->sink != NULL && o->len != 0) {
+        o->sink->printf_sink_write(o->sink, o->buf, o->len);
+        o->len = 0;
+    }
+    return;
+}
+
+// 输出 len 个字符，较长的片段不经 buf 直接交给 sink
+static void out(printf_out_t *o, const char *str, size_t len) {
+    o->count += len;
+    if (o->len + len > o->size) {
+        out_flush(o);
+        if (o->sink != NULL && len > o->size / 2) {
+            o->sink->printf_sink_write(o->sink, str, len);
+            return;
+        }
+        // 没有 sink 时截断
+        if (o->len + len > o->size) {
+            len = o->size - o->len;
+        }
+    }
+    char *dst = o->buf + o->len;
+    o->len += len;
+    while (len-- != 0) {
+        *dst++ = *str++;
+    }
+    return;
+}
+
+// 输出 n 个字符 c，n 不大于 0 时不输出
+static void out_pad(printf_out_t *o, char c, int32_t n) {
+    if (n <= 0) {
+        return;
+    }
+    o->count += n;
+    for (; n > 0; n--) {
+        if (o->len == o->size) {
+            out_flush(o);
+            if (o->len == o->size) {
+                break;
+            }
+        }
+        o->buf[o->len++] = c;
+    }
+    return;
+}
+
+// 将整数按指定进制输出。输入：num-整数，type 中有 SIGN 时按有符号数处理；
+// base-进制；size-字符串长度;precision-数字长度 (精读)；type-类型选项。
+static void number(printf_out_t *o, uint64_t num, int base, int size,
+                   int precision, int type) {
+    char        c, sign, tmp[66], prefix[3];
     const char *digits = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    int         i;
+    int         i, n = 0;
     // 若类型 type
     // 指出用小写字母，则定义小写字母集。若类型指出要左调整(靠左边界)，则屏蔽填零标志。
     // 若进制基数小于 2 或大于 36，则退出处理，也即本程序只能处理基数在 2-32
@@ -67,113 +201,82 @@ static char *number(char *str, int num, int base, int size, int precision,
     if (type & SMALL) {
         digits = "0123456789abcdefghijklmnopqrstuvwxyz";
     }
-    if (type & LEFT) {
+    // 左调整或指定了精度时不填零
+    if ((type & LEFT) || precision >= 0) {
         type &= ~ZEROPAD;
     }
     if (base < 2 || base > 36) {
-        return 0;
+        return;
     }
     // 若类型指出要填零，则置字符变量 c='0' (即 ''),否则 c
     // 等于空格字符。若类型指出是带符号数并且 数值 num 小于 0，则置符号变量
     // sign=负号，并使 num 取绝对值。否则如果类型指出是加号， 则置
     // sign=加号，否则若类型带空格标志则 sign=空格，否则置 0
     c = (type & ZEROPAD) ? '0' : ' ';
-    if (type & SIGN && num < 0) {
+    if (type & SIGN && (int64_t)num < 0) {
         sign = '-';
-        num -= num;
+        num  = -num;
     }
     else {
         sign = (type & PLUS) ? '+' : ((type & SPACE) ? ' ' : 0);
     }
-    // 若带符号，则宽度值减 1.若类型指出是特殊转换，则对于十六进制宽度再减少 2
-    // 位(用于 0x)，对于 八进制宽度减 1 (用于八进制转换结果)
     if (sign) {
-        size--;
-    }
-    if (type & SPECIAL) {
-        if (base == 16) {
-            size -= 2;
-        }
-        else if (base == 8) {
-            size--;
-        }
-    }
-    // 如果数值 num 为 0，则临时字符串='0'；否则根据给定的基数将数值 num
-    // 转换成字符形式
-    i = 0;
-    if (num == 0) {
-        tmp[i++] = '0';
+        prefix[n++] = sign;
     }
-    else {
-        while (num != 0) {
-            tmp[i++] = digits[do_div(num, base)];
-        }
-    }
-    // 若数值字符个数大于精读值，则精度值扩展为数字个数值。宽度值减去用于存放数值字符的个数。
-    if (i > precision) {
-        precision = i;
-    }
-    size -= precision;
-    // 从这里真正开始形成所需要的转换结果，并暂时放在字符串 str
-    // 中。若类型中没有填零(ZEROPAD) 和左调整标志，则在 str
-    // 中首先填放剩余宽度值指出的空格数。若需带符号位，则存入符号。
-    if (!(type & (ZEROPAD + LEFT))) {
-        while (size-- > 0) {
-            *str++ = ' ';
-        }
-    }
-    if (sign) {
-        *str++ = sign;
+    // 根据给定的基数将数值 num 转换成字符形式
+    char *p = number_digits(tmp + sizeof(tmp), num, base, digits);
+    i       = tmp + sizeof(tmp) - p;
+    // 精度为 0 时数值 0 不输出数字，八进制的 '#' 仍输出一个 '0'
+    if (num == 0 && precision == 0 && !(base == 8 && (type & SPECIAL))) {
+        i = 0;
     }
     // 若类型指出是特殊转换，则对于八进制转换结果头一位放置一个
-    // '0';而对于十六进制则存放 '0x'.
-    if (type & SPECIAL) {
-        if (base == 8) {
-            *str++ = '0';
+    // '0'(精度已补出前导 0 时不再放置);而对于十六进制则存放 '0x'.
+    // 数值为 0 时不加前缀
+    if ((type & SPECIAL) && num != 0) {
+        if (base == 8 && precision <= i) {
+            prefix[n++] = '0';
         }
         else if (base == 16) {
-            *str++ = '0';
+            prefix[n++] = '0';
             // 'X' 或 'x'
-            *str++ = digits[33];
+            prefix[n++] = digits[33];
         }
     }
-    // 若类型中没有左调整(左靠齐)标志，则在剩余宽度中存放 c 字符('0' 或空格)，见
-    // 49 行。
-    if (!(type & LEFT)) {
-        while (size-- > 0) {
-            *str++ = c;
-        }
+    // 若数值字符个数大于精读值，则精度值扩展为数字个数值。宽度值减去前缀与数字的个数。
+    if (i > precision) {
+        precision = i;
     }
-    // 此时 i 存有数值 num 的数字个数。若数字个数小于精读值，则 str
-    // 中放入(精度值 - i)个 '0'.
-    while (i < precision--) {
-        *str++ = '0';
+    size -= n + precision;
+    // 若类型中没有填零(ZEROPAD) 和左调整标志，则首先填放剩余宽度值指出的空格数。
+    if (!(type & (ZEROPAD + LEFT))) {
+        out_pad(o, ' ', size);
+        size = 0;
     }
-    // 将转换好的数字字符填入 str 中。共 i 个。
-    while (i-- > 0) {
-        *str++ = tmp[i];
+    // 符号与 0x 前缀
+    out(o, prefix, n);
+    // 若类型中没有左调整(左靠齐)标志，则在剩余宽度中存放 c 字符('0' 或空格)
+    if (!(type & LEFT)) {
+        out_pad(o, c, size);
+        size = 0;
     }
+    // 若数字个数小于精读值，则放入(精度值 - i)个 '0'，然后是数字
+    out_pad(o, '0', precision - i);
+    out(o, p, i);
     // 若宽度值仍大于零，则表示类型标志中有左靠齐标志标志。则在剩余宽度中放入空格。
-    while (size-- > 0) {
-        *str++ = ' ';
-    }
-    // 返回转换好的字符串。
-    return str;
+    out_pad(o, ' ', size);
+    return;
 }
 
-// fmt 是格式字符串；args 是个数变化的值；buf 是输出字符缓冲区。
-// 下面函数是送格式化输出到字符串。为了能在内核中使用格式化的输出，Linus
-// 在内核实现了该 C 标准函数。 其中参数 fmt 是格式字符串；args
-// 是个数变化的值；buf 是输出字符缓冲区。请参见本代码列表后面
+// fmt 是格式字符串；args 是个数变化的值；o 是输出状态。
+// 下面函数是送格式化输出到 o。为了能在内核中使用格式化的输出，Linus
+// 在内核实现了 vsprintf。这里将其改为边格式化边输出，
+// 不需要与输出等长的中间缓冲区。请参见本代码列表后面
 // 的有关格式转换字符的介绍。
-int32_t vsprintf(char *buf, const char *fmt, va_list args);
-int32_t vsprintf(char *buf, const char *fmt, va_list args) {
-    int32_t len;
-    int32_t i;
-    // 用于存放转换过程中的字符串
-    char *   str;
-    char *   s;
-    int32_t *ip;
+static void vformat(printf_out_t *o, const char *fmt, va_list args) {
+    int32_t     len;
+    const char *s;
+    int32_t *   ip;
     // flags to number()
     uint32_t flags;
     // width of output field
@@ -182,15 +285,22 @@ int32_t vsprintf(char *buf, const char *fmt, va_list args) {
     int32_t precision;
     // fields.  min.整数数字个数；max. 字符串中字符个数
     // 'h','l',or 'L' for integer fields
-    int32_t qualifier __attribute__((unused));
+    // "hh" 记为 'H'，"ll" 记为 'L'
+    int32_t qualifier;
+    // 整数的进制与数值
+    int32_t  base;
+    uint64_t num;
 
-    // 首先将字符指针指向
-    // buf，然后扫描格式字符串，对各个格式转换只是进行相应的处理.
+    // 扫描格式字符串，对各个格式转换只是进行相应的处理.
     // 格式转换指示字符串均以 '%' 开始，这里从 fmt 格式字符串中扫描
-    // '%'，寻找格式转换字符串的开始。 不是格式指示的一般字符均被依次存入 str
-    for (str = buf; *fmt; ++fmt) {
+    // '%'，寻找格式转换字符串的开始。 不是格式指示的一般字符整段输出
+    while (*fmt) {
         if (*fmt != '%') {
-            *str++ = *fmt;
+            s = fmt;
+            while (*fmt && *fmt != '%') {
+                fmt++;
+            }
+            out(o, s, fmt - s);
             continue;
         }
         // 下面取得格式指示字符串中的标志域，并将标志常量放入 flags 变量中
@@ -237,7 +347,8 @@ int32_t vsprintf(char *buf, const char *fmt, va_list args) {
             field_width = skip_atoi(&fmt);
         }
         else if (*fmt == '*') {
-            // it's the next argument     这里应该插入 ++fmt;
+            // it's the next argument
+            ++fmt;
             field_width = va_arg(args, int);
             if (field_width < 0) {
                 field_width = -field_width;
@@ -258,6 +369,7 @@ int32_t vsprintf(char *buf, const char *fmt, va_list args) {
             }
             else if (*fmt == '*') {
                 // it's the next argument
+                ++fmt;
                 precision = va_arg(args, int);
             }
             if (precision < 0) {
@@ -267,75 +379,74 @@ int32_t vsprintf(char *buf, const char *fmt, va_list args) {
         // 下面这段代码分析长度修饰符，并将其存入 qualifier 变量。(h,l,L
         // 的含义参见列表后的说明) get the conversion qualifier
         qualifier = -1;
-        if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L') {
+        if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L' || *fmt == 'z' ||
+            *fmt == 'j' || *fmt == 't') {
             qualifier = *fmt;
             ++fmt;
+            if (qualifier == 'l' && *fmt == 'l') {
+                qualifier = 'L';
+                ++fmt;
+            }
+            else if (qualifier == 'h' && *fmt == 'h') {
+                qualifier = 'H';
+                ++fmt;
+            }
         }
         // 下面分析转换指示符。如果转换指示符是
         // 'c'，则表示对应参数应是字符。此时如果标志域表明不是左
         // 对齐，则该字段前面放入宽度域值 -1
         // 个空格字符，然后再被放入参数字符。如果宽度域还大于 0，
         // 则表示为左对齐，则在参数字符后面添加宽度值 -1 个空格字符
-        switch (*fmt) {
+        switch (*fmt++) {
             case 'c': {
+                char ch = (uint8_t)va_arg(args, int);
                 if (!(flags & LEFT)) {
-                    while (--field_width > 0) {
-                        *str++ = ' ';
-                    }
+                    out_pad(o, ' ', field_width - 1);
                 }
-                *str++ = (uint8_t)va_arg(args, int);
-                while (--field_width > 0) {
-                    *str++ = ' ';
+                out(o, &ch, 1);
+                if (flags & LEFT) {
+                    out_pad(o, ' ', field_width - 1);
                 }
-                break;
+                continue;
             }
             // 如果转换指示符是
             // 's',则表示对应参数是字符串。首先取参数字符串的长度，若其超过了精度域值，则
-            // 拓展精度域=字符串长度。此时如果标志域表明不是左靠齐，则该字段前放入(宽度值-字符串长度)个空格
+            // 只取精度域个字符。此时如果标志域表明不是左靠齐，则该字段前放入(宽度值-字符串长度)个空格
             // 字符。然后再放入参数字符串。如果宽度域还大于
             // 0，则表示为左靠齐，则在参数字符串后面添加(宽度值-
             // 字符串长度)个空格字符。
             case 's': {
-                s   = va_arg(args, char *);
-                len = strlen(s);
-                if (precision < 0) {
-                    precision = len;
-                }
-                else if (len > precision) {
-                    len = precision;
+                s = va_arg(args, char *);
+                if (s == NULL) {
+                    s = "(null)";
                 }
+                len = (precision < 0) ? strlen(s) : strnlen(s, precision);
                 if (!(flags & LEFT)) {
-                    while (len < field_width--) {
-                        *str++ = ' ';
-                    }
-                }
-                for (i = 0; i < len; ++i) {
-                    *str++ = *s++;
+                    out_pad(o, ' ', field_width - len);
                 }
-                while (len < field_width--) {
-                    *str++ = ' ';
+                out(o, s, len);
+                if (flags & LEFT) {
+                    out_pad(o, ' ', field_width - len);
                 }
-                break;
+                continue;
             }
             // 如果格式转换符是
-            // 'o',则表示需要将对应的参数转换成八进制数的字符串。调用 number()
-            // 函数处理。
+            // 'o',则表示需要将对应的参数转换成八进制数的字符串。
             case 'o': {
-                str = number(str, va_arg(args, uint32_t), 8, field_width,
-                             precision, flags);
+                base = 8;
                 break;
             }
             // 如果格式转换符是
             // 'p'，表示对应参数的一个指针类型。此时若该参数没有设置宽度域，则默认宽度为
-            // 8， 并且需要添零。然后调用 number() 函数进行处理。
+            // 指针的十六进制位数， 并且需要添零。然后调用 number() 函数进行处理。
             case 'p': {
                 if (field_width == -1) {
-                    field_width = 8;
+                    field_width = sizeof(void *) * 2;
                     flags |= ZEROPAD;
                 }
-                str = number(str, (uint32_t)va_arg(args, void *), 16,
-                             field_width, precision, flags);
-                break;
+                number(o, (ptr_t)va_arg(args, void *), 16, field_width,
+                       precision, flags);
+                continue;
             }
             // 若格式转换指示是 'x'  或
             // 'X'，则表示对应参数需打印成十六进制数输出。'x'
@@ -345,8 +456,7 @@ int32_t vsprintf(char *buf, const char *fmt, va_list args) {
                 __attribute__((fallthrough));
             }
             case 'X': {
-                str = number(str, va_arg(args, uint32_t), 16, field_width,
-                             precision, flags);
+                base = 16;
                 break;
             }
             // 如果格式转换字符是 'd','i' 或 'u'，则表示对应参数是整数。'd','i'
@@ -357,42 +467,112 @@ int32_t vsprintf(char *buf, const char *fmt, va_list args) {
                 __attribute__((fallthrough));
             }
             case 'u': {
-                str = number(str, va_arg(args, uint32_t), 10, field_width,
-                             precision, flags);
+                base = 10;
                 break;
             }
             // 若格式转换指示符是
-            // 'n'，则表示要把到目前为止转换输出的字符保存到对应参数指针指定的位置中。
-            // 首先利用 va_arg()
-            // 取得该参数指针，然后将已经转换好的字符存入该指针所指的位置。
+            // 'n'，则表示要把到目前为止转换输出的字符数保存到对应参数指针指定的位置中。
             case 'n': {
                 ip  = va_arg(args, int *);
-                *ip = (str - buf);
-                break;
+                *ip = o->count;
+                continue;
             }
             // 若格式转换符不是 '%' ，则表示格式字符串有错，直接将一个 '%'
             // 写入输出中。如果格式转换符的
-            // 位置处还有字符，则也直接将该字符写入输出串中，并返回到 117
-            // 行处继续处理格式字符串。否则表示
+            // 位置处还有字符，则也直接将该字符写入输出串中，继续处理格式字符串。否则表示
             // 已经处理到格式字符串的结尾处，则退出循环。
             default: {
+                --fmt;
                 if (*fmt != '%') {
-                    *str++ = '%';
+                    out(o, "%", 1);
                 }
                 if (*fmt) {
-                    *str++ = *fmt;
+                    out(o, fmt, 1);
+                    ++fmt;
                 }
-                else {
-                    --fmt;
-                }
-                break;
+                continue;
             }
         }
+        // 整数：按长度修饰符取出参数。"ll" 与 'j' 为 64 位，其余为 32 位
+        if (qualifier == 'L' || qualifier == 'j') {
+            num = va_arg(args, uint64_t);
+        }
+        else if (flags & SIGN) {
+            int32_t val = va_arg(args, int32_t);
+            if (qualifier == 'h') {
+                val = (int16_t)val;
+            }
+            else if (qualifier == 'H') {
+                val = (int8_t)val;
+            }
+            num = (int64_t)val;
+        }
+        else {
+            uint32_t val = va_arg(args, uint32_t);
+            if (qualifier == 'h') {
+                val = (uint16_t)val;
+            }
+            else if (qualifier == 'H') {
+                val = (uint8_t)val;
+            }
+            num = val;
+        }
+        number(o, num, base, field_width, precision, flags);
     }
-    // 最后在转换好的字符串结尾处添上 null
-    *str = '\0';
-    // 返回转换好的字符串长度值
-    return str - buf;
+    return;
+}
+
+int32_t vprintf_sink(printf_sink_t *sink, const char *fmt, va_list args) {
+    char         stage[PRINTF_STAGE_SIZE];
+    printf_out_t o = {
+        .sink  = sink,
+        .buf   = stage,
+        .size  = sizeof(stage),
+        .len   = 0,
+        .count = 0,
+    };
+    vformat(&o, fmt, args);
+    out_flush(&o);
+    return o.count;
+}
+
+// 直接写入 buf，保留一个字节存放 '\0'
+int32_t vsnprintf(char *buf, size_t size, const char *fmt, va_list args) {
+    printf_out_t o = {
+        .sink  = NULL,
+        .buf   = buf,
+        .size  = size > 0 ? size - 1 : 0,
+        .len   = 0,
+        .count = 0,
+    };
+    vformat(&o, fmt, args);
+    if (size > 0) {
+        buf[o.len] = '\0';
+    }
+    return o.count;
+}
+
+int32_t snprintf(char *buf, size_t size, const char *fmt, ...) {
+    va_list args;
+    int32_t i;
+    va_start(args, fmt);
+    i = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return i;
+}
+
+// 不检查 buf 大小
+int32_t vsprintf(char *buf, const char *fmt, va_list args) {
+    return vsnprintf(buf, PRINTF_SIZE_MAX, fmt, args);
+}
+
+int32_t sprintf(char *buf, const char *fmt, ...) {
+    va_list args;
+    int32_t i;
+    va_start(args, fmt);
+    i = vsprintf(buf, fmt, args);
+    va_end(args);
+    return i;
 }
 
 #ifdef __cplusplus
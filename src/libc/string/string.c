@@ -10,31 +10,139 @@ extern "C" {
 
 #include "string.h"
 
+// 允许与其它类型别名的 32 位字，用于按字访问任意缓冲区
+typedef uint32_t __attribute__((__may_alias__)) string_word_t;
+
+// 每个字节均为 0x01、0x80 的字
+#define STRING_ONES (0x01010101UL)
+#define STRING_HIGHS (0x80808080UL)
+
+// 字中是否有为 0 的字节
+static inline bool string_has_zero(uint32_t word) {
+    return ((word - STRING_ONES) & ~word & STRING_HIGHS) != 0;
+}
+
+// 以下函数先逐字节处理到 4 字节对齐，之后按字读取
+// 对齐的字不会跨页，读到字符串结尾之后的字节也不会引起缺页
+
 // 获取字符串长度
 size_t strlen(const char *str) {
-    size_t len = 0;
-    while (str[len]) {
-        len++;
+    const char *p = str;
+    for (; ((ptr_t)p & 3) != 0; p++) {
+        if (*p == '\0') {
+            return p - str;
+        }
+    }
+    const string_word_t *w = (const string_word_t *)p;
+    while (string_has_zero(*w) == false) {
+        w++;
+    }
+    for (p = (const char *)w; *p != '\0'; p++) {
+        ;
+    }
+    return p - str;
+}
+
+// 获取字符串长度，最多为 maxlen
+size_t strnlen(const char *str, size_t maxlen) {
+    const char *p   = str;
+    const char *end = str + maxlen;
+    for (; p < end && ((ptr_t)p & 3) != 0; p++) {
+        if (*p == '\0') {
+            return p - str;
+        }
+    }
+    const string_word_t *w = (const string_word_t *)p;
+    while ((size_t)(end - (const char *)w) >= 4 &&
+           string_has_zero(*w) == false) {
+        w++;
     }
-    return len;
+    for (p = (const char *)w; p < end && *p != '\0'; p++) {
+        ;
+    }
+    return p - str;
 }
 
 // 如果 src > dest, 则返回值大于 0，如果 src = dest, 则返回值等于 0，
-// 如果 srd  < dest ,则返回值小于 0。
-int8_t strcmp(const char *src, const char *dest) {
-    while (*src && *dest && (*src == *dest)) {
-        src++;
-        dest++;
+// 如果 src < dest, 则返回值小于 0。
+int strcmp(const char *src, const char *dest) {
+    const uint8_t *s1 = (const uint8_t *)src;
+    const uint8_t *s2 = (const uint8_t *)dest;
+    // 两者的对齐相同时可以按字比较
+    if ((((ptr_t)s1 ^ (ptr_t)s2) & 3) == 0) {
+        for (; ((ptr_t)s1 & 3) != 0; s1++, s2++) {
+            if (*s1 != *s2 || *s1 == '\0') {
+                return *s1 - *s2;
+            }
+        }
+        const string_word_t *w1 = (const string_word_t *)s1;
+        const string_word_t *w2 = (const string_word_t *)s2;
+        while (*w1 == *w2 && string_has_zero(*w1) == false) {
+            w1++;
+            w2++;
+        }
+        s1 = (const uint8_t *)w1;
+        s2 = (const uint8_t *)w2;
+    }
+    while (*s1 == *s2 && *s1 != '\0') {
+        s1++;
+        s2++;
+    }
+    return *s1 - *s2;
+}
+
+// 最多比较 len 个字符
+int strncmp(const char *src, const char *dest, size_t len) {
+    const uint8_t *s1 = (const uint8_t *)src;
+    const uint8_t *s2 = (const uint8_t *)dest;
+    if ((((ptr_t)s1 ^ (ptr_t)s2) & 3) == 0) {
+        for (; len != 0 && ((ptr_t)s1 & 3) != 0; len--, s1++, s2++) {
+            if (*s1 != *s2 || *s1 == '\0') {
+                return *s1 - *s2;
+            }
+        }
+        const string_word_t *w1 = (const string_word_t *)s1;
+        const string_word_t *w2 = (const string_word_t *)s2;
+        while (len >= 4 && *w1 == *w2 && string_has_zero(*w1) == false) {
+            w1++;
+            w2++;
+            len -= 4;
+        }
+        s1 = (const uint8_t *)w1;
+        s2 = (const uint8_t *)w2;
+    }
+    for (; len != 0; len--, s1++, s2++) {
+        if (*s1 != *s2 || *s1 == '\0') {
+            return *s1 - *s2;
+        }
     }
-    return *src - *dest;
+    return 0;
 }
 
 char *strcpy(char *dest, const char *src) {
-    char *address = dest;
-    while ((*dest++ = *src++) != '\0') {
+    char *d = dest;
+    for (; ((ptr_t)src & 3) != 0; src++) {
+        if ((*d++ = *src) == '\0') {
+            return dest;
+        }
+    }
+    // 按 src 对齐读取，x86 上 dest 不对齐的写入同样可行
+    const string_word_t *w = (const string_word_t *)src;
+    for (; string_has_zero(*w) == false; w++, d += 4) {
+        *(string_word_t *)d = *w;
+    }
+    for (src = (const char *)w; (*d++ = *src++) != '\0';) {
         ;
     }
-    return address;
+    return dest;
+}
+
+// 复制最多 len 个字符，不足 len 时以 0 填充
+char *strncpy(char *dest, const char *src, size_t len) {
+    size_t n = strnlen(src, len);
+    memcpy(dest, src, n);
+    memset(dest + n, 0, len - n);
+    return dest;
 }
 
 void backspace(char *src) {
@@ -49,34 +157,247 @@ void append(char *src, char dest) {
 }
 
 char *strcat(char *dest, const char *src) {
-    uint8_t *add_d = (uint8_t *)dest;
     if (dest != NULL && src != NULL) {
-        while (*add_d) {
-            add_d++;
+        strcpy(dest + strlen(dest), src);
+    }
+    return dest;
+}
+
+// 查找字符 c 第一次出现的位置，c 为 0 时返回字符串结尾
+char *strchr(const char *str, int c) {
+    uint8_t ch = (uint8_t)c;
+    for (; ((ptr_t)str & 3) != 0; str++) {
+        if ((uint8_t)*str == ch) {
+            return (char *)str;
+        }
+        if (*str == '\0') {
+            return NULL;
+        }
+    }
+    uint32_t             mask = ch * STRING_ONES;
+    const string_word_t *w    = (const string_word_t *)str;
+    while (string_has_zero(*w) == false &&
+           string_has_zero(*w ^ mask) == false) {
+        w++;
+    }
+    for (str = (const char *)w;; str++) {
+        if ((uint8_t)*str == ch) {
+            return (char *)str;
+        }
+        if (*str == '\0') {
+            return NULL;
+        }
+    }
+}
+
+// 在前 len 个字节中查找 c
+void *memchr(const void *src, int c, size_t len) {
+    const uint8_t *p  = (const uint8_t *)src;
+    uint8_t        ch = (uint8_t)c;
+    for (; len != 0 && ((ptr_t)p & 3) != 0; len--, p++) {
+        if (*p == ch) {
+            return (void *)p;
+        }
+    }
+    uint32_t             mask = ch * STRING_ONES;
+    const string_word_t *w    = (const string_word_t *)p;
+    for (; len >= 4 && string_has_zero(*w ^ mask) == false; len -= 4) {
+        w++;
+    }
+    for (p = (const uint8_t *)w; len != 0; len--, p++) {
+        if (*p == ch) {
+            return (void *)p;
         }
-        while (*src) {
-            *add_d++ = *src++;
+    }
+    return NULL;
+}
+
+// CPU 支持 ERMS 时 rep movsb/stosb 本身即为最快的实现
+static bool string_erms = false;
+// SIMD 实现
+static const string_simd_t *string_simd = NULL;
+
+void string_init(bool erms) {
+    string_erms = erms;
+    return;
+}
+
+void string_set_simd(const string_simd_t *simd) {
+    string_simd = simd;
+    return;
+}
+
+// 小块复制，每次循环复制 16 字节
+static inline void memcpy_small(uint8_t *dst, const uint8_t *src, size_t len) {
+    for (; len >= 16; len -= 16, dst += 16, src += 16) {
+        string_word_t *d = (string_word_t *)dst;
+        string_word_t *s = (string_word_t *)src;
+        d[0]             = s[0];
+        d[1]             = s[1];
+        d[2]             = s[2];
+        d[3]             = s[3];
+    }
+    for (; len >= 4; len -= 4, dst += 4, src += 4) {
+        *(string_word_t *)dst = *(string_word_t *)src;
+    }
+    while (len-- != 0) {
+        *dst++ = *src++;
+    }
+    return;
+}
+
+void *memcpy(void *dest, const void *src, size_t len) {
+    if (len < STRING_SMALL_SIZE) {
+        memcpy_small((uint8_t *)dest, (const uint8_t *)src, len);
+        return dest;
+    }
+    void *      dst = dest;
+    const void *sr  = src;
+    if (string_simd != NULL && len >= string_simd->threshold) {
+        size_t done = string_simd->string_simd_memcpy(dest, src, len);
+        dst         = (uint8_t *)dst + done;
+        sr          = (const uint8_t *)sr + done;
+        len -= done;
+        if (len < STRING_SMALL_SIZE) {
+            memcpy_small((uint8_t *)dst, (const uint8_t *)sr, len);
+            return dest;
         }
     }
+    if (string_erms == true) {
+        __asm__ volatile("rep movsb"
+                         : "+D"(dst), "+S"(sr), "+c"(len)
+                         :
+                         : "memory");
+        return dest;
+    }
+    // 先按字节对齐目标地址，再按双字复制，最后处理剩余字节
+    size_t head = (-(ptr_t)dst) & 3;
+    size_t body = (len - head) >> 2;
+    size_t tail = (len - head) & 3;
+    __asm__ volatile("rep movsb\n\t"
+                     "mov %3, %%ecx\n\t"
+                     "rep movsl\n\t"
+                     "mov %4, %%ecx\n\t"
+                     "rep movsb"
+                     : "+D"(dst), "+S"(sr), "+c"(head)
+                     : "r"(body), "r"(tail)
+                     : "memory");
     return dest;
 }
 
-void memcpy(void *dest, void *src, uint32_t len) {
-    uint8_t *sr  = (uint8_t *)src;
-    uint8_t *dst = (uint8_t *)dest;
-    while (len != 0) {
-        *dst++ = *sr++;
-        len--;
+// 小块填充，每次循环填充 16 字节
+static inline void memset_small(uint8_t *dst, uint32_t word, size_t len) {
+    for (; len >= 16; len -= 16, dst += 16) {
+        string_word_t *d = (string_word_t *)dst;
+        d[0]             = word;
+        d[1]             = word;
+        d[2]             = word;
+        d[3]             = word;
+    }
+    for (; len >= 4; len -= 4, dst += 4) {
+        *(string_word_t *)dst = word;
+    }
+    while (len-- != 0) {
+        *dst++ = (uint8_t)word;
     }
+    return;
 }
-void memset(void *dest, uint8_t val, uint32_t len) {
-    for (uint8_t *dst = (uint8_t *)dest; len != 0; len--) {
-        *dst++ = val;
+
+void *memset(void *dest, int val, size_t len) {
+    uint32_t word = (uint8_t)val * 0x01010101UL;
+    if (len < STRING_SMALL_SIZE) {
+        memset_small((uint8_t *)dest, word, len);
+        return dest;
+    }
+    void *dst = dest;
+    if (string_simd != NULL && len >= string_simd->threshold) {
+        size_t done = string_simd->string_simd_memset(dest, val, len);
+        dst         = (uint8_t *)dst + done;
+        len -= done;
+        if (len < STRING_SMALL_SIZE) {
+            memset_small((uint8_t *)dst, word, len);
+            return dest;
+        }
     }
+    if (string_erms == true) {
+        __asm__ volatile("rep stosb"
+                         : "+D"(dst), "+c"(len)
+                         : "a"(word)
+                         : "memory");
+        return dest;
+    }
+    size_t head = (-(ptr_t)dst) & 3;
+    size_t body = (len - head) >> 2;
+    size_t tail = (len - head) & 3;
+    __asm__ volatile("rep stosb\n\t"
+                     "mov %2, %%ecx\n\t"
+                     "rep stosl\n\t"
+                     "mov %3, %%ecx\n\t"
+                     "rep stosb"
+                     : "+D"(dst), "+c"(head)
+                     : "r"(body), "r"(tail), "a"(word)
+                     : "memory");
+    return dest;
 }
 
-void bzero(void *dest, uint32_t len) {
+void bzero(void *dest, size_t len) {
     memset(dest, 0, len);
+    return;
+}
+
+int memcmp(const void *src1, const void *src2, size_t len) {
+    const uint8_t *s1 = (const uint8_t *)src1;
+    const uint8_t *s2 = (const uint8_t *)src2;
+    if (string_simd != NULL && len >= string_simd->threshold) {
+        size_t done = string_simd->string_simd_memcmp(s1, s2, len);
+        s1 += done;
+        s2 += done;
+        len -= done;
+    }
+    // 按字跳过相等的部分，再按字节找到第一个不同的字节
+    for (; len >= 4; len -= 4, s1 += 4, s2 += 4) {
+        if (*(const string_word_t *)s1 != *(const string_word_t *)s2) {
+            break;
+        }
+    }
+    for (; len != 0; len--, s1++, s2++) {
+        if (*s1 != *s2) {
+            return *s1 - *s2;
+        }
+    }
+    return 0;
+}
+
+// 允许重叠的复制
+void *memmove(void *dest, const void *src, size_t len) {
+    uint8_t *      d = (uint8_t *)dest;
+    const uint8_t *s = (const uint8_t *)src;
+    if (d + len <= s || s + len <= d) {
+        return memcpy(dest, src, len);
+    }
+    // 目标在前时从前向后复制，否则从后向前复制
+    // 每个字先读后写，重叠部分总是在被覆盖前读取
+    if (d < s) {
+        for (; len >= 4; len -= 4, d += 4, s += 4) {
+            *(string_word_t *)d = *(const string_word_t *)s;
+        }
+        while (len-- != 0) {
+            *d++ = *s++;
+        }
+    }
+    else if (d > s) {
+        d += len;
+        s += len;
+        for (; len >= 4; len -= 4) {
+            d -= 4;
+            s -= 4;
+            *(string_word_t *)d = *(const string_word_t *)s;
+        }
+        while (len-- != 0) {
+            *--d = *--s;
+        }
+    }
+    return dest;
 }
 
 #ifdef __cplusplus
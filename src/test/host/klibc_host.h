@@ -0,0 +1,44 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// klibc_host.h for Simple-XX/SimpleKernel.
+
+// 在主机上编译内核 C 库时强制包含（-include）的头文件
+// 1. 内核的 stdarg.h 按 i386 栈布局取参数，主机上改用编译器内建的实现
+// 2. 内核 C 库的函数加上 klibc_ 前缀，避免与 glibc 冲突
+
+#ifndef _KLIBC_HOST_H_
+#define _KLIBC_HOST_H_
+
+// 使内核的 stdarg.h 不再生效
+#define _STDARG_H_
+typedef __builtin_va_list va_list;
+#define va_start(AP, LASTARG) __builtin_va_start(AP, LASTARG)
+#define va_arg(AP, TYPE) __builtin_va_arg(AP, TYPE)
+#define va_end(AP) __builtin_va_end(AP)
+
+#define string_init klibc_string_init
+#define string_set_simd klibc_string_set_simd
+#define memcpy klibc_memcpy
+#define memmove klibc_memmove
+#define memset klibc_memset
+#define bzero klibc_bzero
+#define memcmp klibc_memcmp
+#define memchr klibc_memchr
+#define strcmp klibc_strcmp
+#define strncmp klibc_strncmp
+#define strcpy klibc_strcpy
+#define strncpy klibc_strncpy
+#define strcat klibc_strcat
+#define strchr klibc_strchr
+#define strlen klibc_strlen
+#define strnlen klibc_strnlen
+#define backspace klibc_backspace
+#define append klibc_append
+#define vprintf_sink klibc_vprintf_sink
+#define vsnprintf klibc_vsnprintf
+#define snprintf klibc_snprintf
+#define vsprintf klibc_vsprintf
+#define sprintf klibc_sprintf
+
+#endif /* _KLIBC_HOST_H_ */
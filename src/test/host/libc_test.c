@@ -0,0 +1,445 @@
+// This file is a part of Simple-XX/SimpleKernel
+// (https://github.com/Simple-XX/SimpleKernel).
+//
+// libc_test.c for Simple-XX/SimpleKernel.
+
+// 在主机上将内核 C 库与 glibc 对比
+// 不带参数时用随机的长度、对齐与格式检查正确性，失败时返回非 0
+// --bench 时输出各长度下的吞吐量
+// --seed N 指定随机数种子
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 内核 C 库中 size_t 为 32 位
+typedef unsigned int ksize_t;
+
+extern void   klibc_string_init(bool erms);
+extern void * klibc_memcpy(void *dest, const void *src, ksize_t len);
+extern void * klibc_memmove(void *dest, const void *src, ksize_t len);
+extern void * klibc_memset(void *dest, int val, ksize_t len);
+extern int    klibc_memcmp(const void *src1, const void *src2, ksize_t len);
+extern void * klibc_memchr(const void *src, int c, ksize_t len);
+extern int    klibc_strcmp(const char *src, const char *dest);
+extern int    klibc_strncmp(const char *src, const char *dest, ksize_t len);
+extern char * klibc_strcpy(char *dest, const char *src);
+extern char * klibc_strncpy(char *dest, const char *src, ksize_t len);
+extern char * klibc_strcat(char *dest, const char *src);
+extern char * klibc_strchr(const char *str, int c);
+extern ksize_t klibc_strlen(const char *src);
+extern ksize_t klibc_strnlen(const char *src, ksize_t maxlen);
+extern int32_t klibc_snprintf(char *buf, ksize_t size, const char *fmt, ...);
+
+// 缓冲区大小，前后各留 64 字节用于检查越界
+#define TEST_BUF_SIZE (1024 * 1024)
+#define TEST_GUARD (64)
+// 每种检查的随机次数
+#define TEST_ROUNDS (20000)
+
+static uint8_t  src_buf[TEST_BUF_SIZE + 2 * TEST_GUARD];
+static uint8_t  kern_buf[TEST_BUF_SIZE + 2 * TEST_GUARD];
+static uint8_t  host_buf[TEST_BUF_SIZE + 2 * TEST_GUARD];
+static uint64_t rand_state = 0x2545F4914F6CDD1DULL;
+static uint32_t failures;
+
+// xorshift64
+static uint64_t rand64(void) {
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+static uint32_t rand_below(uint32_t n) {
+    return (uint32_t)(rand64() % n);
+}
+
+// 长度分布：多数为短长度，少数覆盖大块路径
+static uint32_t rand_len(void) {
+    uint32_t r = rand_below(64);
+    if (r == 0) {
+        return rand_below(TEST_BUF_SIZE - 16);
+    }
+    if (r < 16) {
+        return rand_below(8192);
+    }
+    return rand_below(300);
+}
+
+static void rand_fill(uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)rand64();
+    }
+    return;
+}
+
+static int sign(int v) {
+    return (v > 0) - (v < 0);
+}
+
+#define CHECK(cond, ...)                                                       \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            failures++;                                                        \
+            if (failures <= 20) {                                              \
+                printf("FAIL %s:%d: ", __func__, __LINE__);                    \
+                printf(__VA_ARGS__);                                           \
+                printf("\n");                                                  \
+            }                                                                  \
+        }                                                                      \
+    } while (0)
+
+static void check_mem(void) {
+    uint8_t *src  = src_buf + TEST_GUARD;
+    uint8_t *kern = kern_buf + TEST_GUARD;
+    uint8_t *host = host_buf + TEST_GUARD;
+    for (uint32_t r = 0; r < TEST_ROUNDS; r++) {
+        uint32_t len   = rand_len();
+        uint32_t soff  = rand_below(16);
+        uint32_t doff  = rand_below(16);
+        size_t   touch = len + 32 + TEST_GUARD;
+        rand_fill(src, len + 16);
+        rand_fill(kern_buf, touch);
+        memcpy(host_buf, kern_buf, touch);
+        // memcpy
+        CHECK(klibc_memcpy(kern + doff, src + soff, len) == kern + doff,
+              "memcpy return len %u", len);
+        memcpy(host + doff, src + soff, len);
+        CHECK(memcmp(kern_buf, host_buf, touch) == 0,
+              "memcpy len %u soff %u doff %u", len, soff, doff);
+        // memmove，在同一缓冲区内重叠复制
+        uint32_t mlen = len > 32 ? len - 32 : len;
+        klibc_memmove(kern + doff, kern + soff, mlen);
+        memmove(host + doff, host + soff, mlen);
+        CHECK(memcmp(kern_buf, host_buf, touch) == 0,
+              "memmove len %u soff %u doff %u", mlen, soff, doff);
+        // memset
+        int val = (int)rand64();
+        klibc_memset(kern + doff, val, len);
+        memset(host + doff, val, len);
+        CHECK(memcmp(kern_buf, host_buf, touch) == 0,
+              "memset len %u doff %u", len, doff);
+        // memcmp，随机修改一个字节
+        memcpy(kern + doff, src + soff, len);
+        if (len > 0 && rand_below(4) != 0) {
+            kern[doff + rand_below(len)] ^= 1 + rand_below(255);
+        }
+        CHECK(sign(klibc_memcmp(kern + doff, src + soff, len)) ==
+                  sign(memcmp(kern + doff, src + soff, len)),
+              "memcmp len %u soff %u doff %u", len, soff, doff);
+        // memchr
+        int c = (int)rand64();
+        CHECK(klibc_memchr(src + soff, c, len) == memchr(src + soff, c, len),
+              "memchr len %u soff %u c %d", len, soff, c & 0xFF);
+    }
+    return;
+}
+
+// 生成长度为 len 的随机字符串，字符不含 '\0'
+// 字符只取 few 个值时，比较与查找更容易命中
+static void rand_str(char *str, uint32_t len, uint32_t few) {
+    for (uint32_t i = 0; i < len; i++) {
+        str[i] = (char)(few != 0 ? 'a' + rand_below(few) : 1 + rand_below(255));
+    }
+    str[len] = '\0';
+    return;
+}
+
+static void check_str(void) {
+    static char a[1024], b[1024], kern[2048], host[2048];
+    for (uint32_t r = 0; r < TEST_ROUNDS; r++) {
+        uint32_t off  = rand_below(8);
+        uint32_t few  = rand_below(2) ? 3 : 0;
+        uint32_t alen = rand_below(300);
+        char *   s    = a + off;
+        rand_str(s, alen, few);
+        // b 与 a 有一段相同的前缀
+        uint32_t boff = rand_below(8);
+        char *   t    = b + boff;
+        uint32_t pre  = rand_below(alen + 1);
+        memcpy(t, s, pre);
+        rand_str(t + pre, rand_below(300), few);
+        CHECK(klibc_strlen(s) == strlen(s), "strlen len %u off %u", alen, off);
+        uint32_t max = rand_below(400);
+        CHECK(klibc_strnlen(s, max) == strnlen(s, max),
+              "strnlen len %u max %u off %u", alen, max, off);
+        int c = rand_below(8) == 0 ? 0
+                : few != 0         ? 'a' + (int)rand_below(4)
+                                   : (int)rand64();
+        CHECK(klibc_strchr(s, c) == strchr(s, c), "strchr len %u off %u c %d",
+              alen, off, c & 0xFF);
+        CHECK(sign(klibc_strcmp(s, t)) == sign(strcmp(s, t)),
+              "strcmp pre %u off %u/%u", pre, off, boff);
+        uint32_t n = rand_below(400);
+        CHECK(sign(klibc_strncmp(s, t, n)) == sign(strncmp(s, t, n)),
+              "strncmp pre %u n %u off %u/%u", pre, n, off, boff);
+        // 复制与拼接，比较整个目标缓冲区
+        rand_fill((uint8_t *)kern, sizeof(kern));
+        memcpy(host, kern, sizeof(kern));
+        uint32_t doff = rand_below(8);
+        klibc_strcpy(kern + doff, s);
+        strcpy(host + doff, s);
+        CHECK(memcmp(kern, host, sizeof(kern)) == 0, "strcpy len %u off %u/%u",
+              alen, off, doff);
+        klibc_strcat(kern + doff, t);
+        strcat(host + doff, t);
+        CHECK(memcmp(kern, host, sizeof(kern)) == 0, "strcat off %u/%u", off,
+              doff);
+        klibc_strncpy(kern + doff, t, n);
+        strncpy(host + doff, t, n);
+        CHECK(memcmp(kern, host, sizeof(kern)) == 0, "strncpy n %u off %u/%u",
+              n, off, doff);
+    }
+    return;
+}
+
+// 随机生成一个转换说明，追加到 fmt，返回参数的类型
+enum { ARG_NONE, ARG_INT, ARG_LONG, ARG_LLONG, ARG_STR, ARG_CHAR };
+
+static int rand_spec(char *fmt, uint64_t *value, const char **str) {
+    static const char *strs[] = {"", "a", "hello", "SimpleKernel", "0123456789"};
+    static const char *lens[] = {"", "hh", "h", "l", "ll", "z"};
+    static const char  ints[] = "diuxXo";
+    char               flags[8];
+    int                n = 0;
+    int                type;
+    char               conv;
+    const char *       len = "";
+    switch (rand_below(8)) {
+        case 0:
+            conv = 's';
+            type = ARG_STR;
+            break;
+        case 1:
+            conv = 'c';
+            type = ARG_CHAR;
+            break;
+        case 2:
+            conv = '%';
+            type = ARG_NONE;
+            break;
+        default:
+            conv = ints[rand_below(6)];
+            len  = lens[rand_below(6)];
+            type = strcmp(len, "ll") == 0 ? ARG_LLONG
+                   : (strcmp(len, "l") == 0 || strcmp(len, "z") == 0)
+                       ? ARG_LONG
+                       : ARG_INT;
+            break;
+    }
+    *value = rand64() >> rand_below(64);
+    if (rand_below(2)) {
+        *value = -*value;
+    }
+    *str          = strs[rand_below(5)];
+    int  width    = rand_below(3) ? -1 : (int)rand_below(25);
+    int  prec     = rand_below(3) ? -1 : (int)rand_below(25);
+    bool integer  = type == ARG_INT || type == ARG_LONG || type == ARG_LLONG;
+    if (conv == '%' || type == ARG_CHAR) {
+        prec = -1;
+    }
+    if (type != ARG_NONE) {
+        if (rand_below(4) == 0) {
+            flags[n++] = '-';
+        }
+        if (integer && rand_below(3) == 0) {
+            flags[n++] = '0';
+        }
+        if (integer && (conv == 'd' || conv == 'i') && rand_below(4) == 0) {
+            flags[n++] = rand_below(2) ? '+' : ' ';
+        }
+        if ((conv == 'x' || conv == 'X' || conv == 'o') && rand_below(3) == 0) {
+            flags[n++] = '#';
+        }
+    }
+    flags[n] = '\0';
+    fmt += strlen(fmt);
+    fmt += sprintf(fmt, "%%%s", flags);
+    if (width >= 0) {
+        fmt += sprintf(fmt, "%d", width);
+    }
+    if (prec >= 0) {
+        fmt += sprintf(fmt, ".%d", prec);
+    }
+    sprintf(fmt, "%s%c", len, conv);
+    return type;
+}
+
+// 用同一组参数调用两个实现
+#define CALL_BOTH(kret, hret, kbuf, hbuf, size, fmt, ...)                      \
+    do {                                                                       \
+        kret = klibc_snprintf(kbuf, size, fmt, __VA_ARGS__);                   \
+        hret = snprintf(hbuf, size, fmt, __VA_ARGS__);                         \
+    } while (0)
+
+static void check_printf(void) {
+    char kbuf[512], hbuf[512];
+    for (uint32_t r = 0; r < TEST_ROUNDS * 4; r++) {
+        char        fmt[64] = "<";
+        uint64_t    v;
+        const char *s;
+        int         type = rand_spec(fmt, &v, &s);
+        strcat(fmt, ">");
+        // 偶尔使用很小的缓冲区，检查截断
+        uint32_t size = rand_below(8) == 0 ? rand_below(16) : sizeof(kbuf);
+        memset(kbuf, 0x5A, sizeof(kbuf));
+        memset(hbuf, 0x5A, sizeof(hbuf));
+        int kret = 0, hret = 0;
+        switch (type) {
+            case ARG_NONE:
+                CALL_BOTH(kret, hret, kbuf, hbuf, size, fmt, 0);
+                break;
+            case ARG_INT:
+                CALL_BOTH(kret, hret, kbuf, hbuf, size, fmt, (int)v);
+                break;
+            case ARG_LONG:
+                // 内核中 long 与 size_t 为 32 位，传入可用 32 位表示的值
+                if (strpbrk(fmt, "di") != NULL) {
+                    CALL_BOTH(kret, hret, kbuf, hbuf, size, fmt,
+                              (long)(int32_t)v);
+                }
+                else {
+                    CALL_BOTH(kret, hret, kbuf, hbuf, size, fmt,
+                              (unsigned long)(uint32_t)v);
+                }
+                break;
+            case ARG_LLONG:
+                CALL_BOTH(kret, hret, kbuf, hbuf, size, fmt, (long long)v);
+                break;
+            case ARG_STR:
+                CALL_BOTH(kret, hret, kbuf, hbuf, size, fmt, s);
+                break;
+            case ARG_CHAR:
+                CALL_BOTH(kret, hret, kbuf, hbuf, size, fmt,
+                          'A' + (int)(v % 26));
+                break;
+        }
+        CHECK(kret == hret && memcmp(kbuf, hbuf, sizeof(kbuf)) == 0,
+              "snprintf(%u, \"%s\") value 0x%llx: \"%.*s\" (%d) expected "
+              "\"%.*s\" (%d)",
+              size, fmt, (unsigned long long)v, (int)(size ? size : 1),
+              size ? kbuf : "", kret, (int)(size ? size : 1), size ? hbuf : "",
+              hret);
+    }
+    return;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static volatile uint64_t bench_sink;
+
+// 每个长度复制约 256MB，输出 GB/s
+static void bench_mem(void) {
+    static const uint32_t sizes[] = {8, 64, 512, 4096, 65536, TEST_BUF_SIZE};
+    uint8_t *             src     = src_buf + TEST_GUARD;
+    uint8_t *             dst     = kern_buf + TEST_GUARD;
+    rand_fill(src, TEST_BUF_SIZE);
+    memset(src + TEST_BUF_SIZE - 1, 0, 1);
+    printf("%-8s %10s %10s %10s %10s %10s %10s %10s %10s\n", "size",
+           "memcpy", "glibc", "memset", "glibc", "memcmp", "glibc", "strlen",
+           "glibc");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t size  = sizes[i];
+        uint32_t loops = (256u << 20) / size;
+        double   gbs[8];
+        for (int impl = 0; impl < 2; impl++) {
+            uint64_t start = now_ns();
+            for (uint32_t j = 0; j < loops; j++) {
+                impl ? memcpy(dst, src, size) : klibc_memcpy(dst, src, size);
+                __asm__ volatile("" : : : "memory");
+            }
+            gbs[0 + impl] = (double)loops * size / (now_ns() - start);
+            start         = now_ns();
+            for (uint32_t j = 0; j < loops; j++) {
+                impl ? memset(dst, j, size) : klibc_memset(dst, j, size);
+                __asm__ volatile("" : : : "memory");
+            }
+            gbs[2 + impl] = (double)loops * size / (now_ns() - start);
+            memcpy(dst, src, size);
+            start = now_ns();
+            for (uint32_t j = 0; j < loops; j++) {
+                bench_sink += impl ? memcmp(dst, src, size)
+                                   : klibc_memcmp(dst, src, size);
+            }
+            gbs[4 + impl] = (double)loops * size / (now_ns() - start);
+            // 以 size - 1 个非 0 字节结尾的字符串
+            memset(dst, 'a', size - 1);
+            dst[size - 1] = '\0';
+            start         = now_ns();
+            for (uint32_t j = 0; j < loops; j++) {
+                bench_sink += impl ? strlen((char *)dst)
+                                   : klibc_strlen((char *)dst);
+                __asm__ volatile("" : : : "memory");
+            }
+            gbs[6 + impl] = (double)loops * size / (now_ns() - start);
+        }
+        printf("%-8u", size);
+        for (int k = 0; k < 8; k++) {
+            printf(" %10.2f", gbs[k]);
+        }
+        printf("\n");
+    }
+    return;
+}
+
+static void bench_printf(void) {
+    char     buf[128];
+    uint32_t loops = 1000000;
+    for (int impl = 0; impl < 2; impl++) {
+        uint64_t start = now_ns();
+        for (uint32_t i = 0; i < loops; i++) {
+            if (impl) {
+                snprintf(buf, sizeof(buf), "0x%08X %u %d %llu", i * 4096,
+                         4000000000U - i, -(int)i, 0x123456789ULL * i);
+            }
+            else {
+                klibc_snprintf(buf, sizeof(buf), "0x%08X %u %d %llu", i * 4096,
+                               4000000000U - i, -(int)i, 0x123456789ULL * i);
+            }
+            __asm__ volatile("" : : : "memory");
+        }
+        printf("snprintf %s: %.1f ns per call\n", impl ? "glibc" : "klibc",
+               (double)(now_ns() - start) / loops);
+    }
+    return;
+}
+
+int main(int argc, char **argv) {
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            rand_state = strtoull(argv[++i], NULL, 0) | 1;
+        }
+    }
+    if (bench == true) {
+        klibc_string_init(false);
+        printf("rep movsd/stosd (GB/s):\n");
+        bench_mem();
+        klibc_string_init(true);
+        printf("ERMS (GB/s):\n");
+        bench_mem();
+        bench_printf();
+        return 0;
+    }
+    printf("seed 0x%llx\n", (unsigned long long)rand_state);
+    for (int erms = 0; erms < 2; erms++) {
+        klibc_string_init(erms);
+        check_mem();
+    }
+    check_str();
+    check_printf();
+    printf("%u failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -18,9 +18,34 @@ bool test(void);
 // C 库
 bool test_libc(void);
 
+// 二进制日志
+bool test_binlog(void);
+bool test_klog(void);
+
 // 物理内存
 bool test_pmm(void);
 
+// slab
+bool test_slab(void);
+
+// kmalloc
+bool test_kmalloc(void);
+
+// arena
+bool test_arena(void);
+
+// 内存分析
+bool test_memprof(void);
+
+// vmalloc
+bool test_vmalloc(void);
+
+// 页表页缓存
+bool test_pgtable(void);
+
+// kmap
+bool test_kmap(void);
+
 #ifdef __cplusplus
 }
 #endif
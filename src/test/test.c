@@ -10,23 +10,333 @@ extern "C" {
 
 #include "stdio.h"
 #include "stdint.h"
+#include "string.h"
 #include "assert.h"
+#include "cpu.hpp"
+#include "fpu.h"
 #include "test.h"
 #include "debug.h"
 #include "pmm.h"
+#include "vmm.h"
+#include "vmalloc.h"
+#include "highmem.h"
+#include "slab.h"
+#include "kmalloc.h"
+#include "arena.h"
+#include "memprof.h"
+#include "binlog.h"
+#include "klog.h"
 
 bool test(void) {
     test_libc();
+    test_binlog();
+    test_klog();
     test_pmm();
+    test_slab();
+    test_kmalloc();
+    test_arena();
+    test_memprof();
+    test_vmalloc();
+    test_pgtable();
+    test_kmap();
     return true;
 }
 
-// TODO
+// memcpy/memset 测试缓冲区
+#define TEST_STRING_SIZE (64 * 1024)
+static uint8_t test_string_src[TEST_STRING_SIZE + 32];
+static uint8_t test_string_dst[TEST_STRING_SIZE + 32];
+
+// 检查 dst 与 src 偏移 off 处长度为 len 的 memcpy/memset/memcmp
+static void test_string_check_len(uint8_t *dst, const uint8_t *src,
+                                  uint32_t off, uint32_t len) {
+    bzero(dst, len + 32);
+    assert(memcpy(dst + off, src + 15 - off, len) == dst + off,
+           "memcpy() return error\n");
+    for (uint32_t i = 0; i < len; i++) {
+        assert(dst[off + i] == src[15 - off + i], "memcpy() error\n");
+    }
+    assert(dst[off + len] == 0, "memcpy() overrun\n");
+    assert(memcmp(dst + off, src + 15 - off, len) == 0, "memcmp() error\n");
+    if (len > 0) {
+        // 修改最后一个字节，比较结果应反映其大小
+        uint8_t last       = src[15 - off + len - 1];
+        int     sign       = last == 0xFF ? -1 : 1;
+        dst[off + len - 1] = last + sign;
+        assert(memcmp(dst + off, src + 15 - off, len) * sign > 0 &&
+                   memcmp(src + 15 - off, dst + off, len) * sign < 0,
+               "memcmp() order error\n");
+        dst[off + len - 1] = last;
+    }
+    memset(dst + off, 0x1A5, len);
+    for (uint32_t i = 0; i < len; i++) {
+        assert(dst[off + i] == 0xA5, "memset() error\n");
+    }
+    assert(dst[off + len] == 0, "memset() overrun\n");
+    assert(off == 0 || dst[off - 1] == 0, "memset() underrun\n");
+    return;
+}
+
+// 检查各种对齐与长度下的 memcpy/memset/memcmp
+static void test_string_check(void) {
+    static const uint32_t lens[] = {511, 512, 513, 1000, 4097,
+                                    TEST_STRING_SIZE - 32};
+    for (uint32_t i = 0; i < TEST_STRING_SIZE + 32; i++) {
+        test_string_src[i] = i * 7 + 1;
+    }
+    for (uint32_t off = 0; off < 4; off++) {
+        for (uint32_t len = 0; len < 256; len++) {
+            test_string_check_len(test_string_dst, test_string_src, off, len);
+        }
+    }
+    for (uint32_t off = 0; off < 16; off += 5) {
+        for (uint32_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+            test_string_check_len(test_string_dst, test_string_src, off,
+                                  lens[i]);
+        }
+    }
+    return;
+}
+
+// 检查字符串函数，字符串从不同对齐处开始
+static void test_string_str(void) {
+    static const char *str = "0123456789abcdef0123456789abcdef";
+    char               buf[64];
+    for (uint32_t off = 0; off < 4; off++) {
+        const char *s   = str + off;
+        char *      dst = buf + 3 - off;
+        assert(strlen(s) == 32 - off, "strlen() error\n");
+        assert(strnlen(s, 5) == 5 && strnlen(s, 40) == 32 - off,
+               "strnlen() error\n");
+        assert(strcpy(dst, s) == dst && strcmp(dst, s) == 0,
+               "strcpy() error\n");
+        assert(strchr(s, 'f') == str + 15 && strchr(s, 'x') == NULL &&
+                   strchr(s, '\0') == str + 32,
+               "strchr() error\n");
+        assert(memchr(s, 'a', 10 - off) == NULL &&
+                   memchr(s, 'a', 11 - off) == str + 10,
+               "memchr() error\n");
+        dst[20 - off] = 'z';
+        assert(strcmp(dst, s) > 0 && strcmp(s, dst) < 0 &&
+                   strncmp(dst, s, 20 - off) == 0 &&
+                   strncmp(dst, s, 21 - off) > 0,
+               "strcmp() error\n");
+        strncpy(dst, "abc", 8);
+        assert(strcmp(dst, "abc") == 0 && dst[7] == '\0' && dst[8] == s[8],
+               "strncpy() error\n");
+        assert(strcmp(strcat(dst, "def"), "abcdef") == 0, "strcat() error\n");
+    }
+    // 重叠的复制
+    strcpy(buf, str);
+    memmove(buf + 3, buf, 20);
+    assert(strncmp(buf + 3, str, 20) == 0, "memmove() forward error\n");
+    strcpy(buf, str);
+    memmove(buf, buf + 3, 20);
+    assert(strncmp(buf, str + 3, 20) == 0, "memmove() backward error\n");
+    return;
+}
+
+// 输出不同长度下 memcpy/memset 每次调用的周期数
+static void test_string_bench(const char *name) {
+    static const uint32_t sizes[] = {16, 256, 4096, TEST_STRING_SIZE};
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t loops = (TEST_STRING_SIZE * 4) / sizes[i];
+        uint64_t start = cpu_rdtsc();
+        for (uint32_t j = 0; j < loops; j++) {
+            memcpy(test_string_dst, test_string_src, sizes[i]);
+        }
+        uint32_t copy = (uint32_t)(cpu_rdtsc() - start) / loops;
+        start         = cpu_rdtsc();
+        for (uint32_t j = 0; j < loops; j++) {
+            memset(test_string_dst, j, sizes[i]);
+        }
+        uint32_t set = (uint32_t)(cpu_rdtsc() - start) / loops;
+        printk_test("%s %d bytes: memcpy %d cycles, memset %d cycles\n", name,
+                    sizes[i], copy, set);
+    }
+    return;
+}
+
+// 检查整数格式化并输出耗时
+static void test_sprintf(void) {
+    char buf[64];
+    sprintf(buf, "%d %i %u", -2147483647 - 1, -42, 4294967295U);
+    assert(strcmp(buf, "-2147483648 -42 4294967295") == 0,
+           "sprintf(%d) error\n");
+    sprintf(buf, "%lld %llu", -9223372036854775807LL - 1,
+            18446744073709551615ULL);
+    assert(strcmp(buf, "-9223372036854775808 18446744073709551615") == 0,
+           "sprintf(%lld) error\n");
+    sprintf(buf, "%llX %llo %#x", 0xFEDCBA9876543210ULL, 01234567ULL, 255);
+    assert(strcmp(buf, "FEDCBA9876543210 1234567 0xff") == 0,
+           "sprintf(%llX) error\n");
+    sprintf(buf, "%llu %08X %-4d| %zu %hhd", 10000000000000000000ULL, 0x1234,
+            -5, (size_t)12, 300);
+    assert(strcmp(buf, "10000000000000000000 00001234 -5  | 12 44") == 0,
+           "sprintf(flags) error\n");
+    // 超出缓冲区时截断，返回值仍是完整长度
+    buf[8] = 'x';
+    assert(snprintf(buf, 8, "%s%*d", "01234", 5, 56789) == 10 &&
+               strcmp(buf, "0123456") == 0 && buf[8] == 'x',
+           "snprintf(truncate) error\n");
+    assert(snprintf(buf, sizeof(buf), "%-6s|%.3s|%s", "ab", "abcdef",
+                    (char *)NULL) == 17 &&
+               strcmp(buf, "ab    |abc|(null)") == 0,
+           "snprintf(%s) error\n");
+    uint64_t start = cpu_rdtsc();
+    for (uint32_t i = 0; i < 1000; i++) {
+        sprintf(buf, "0x%08X %u %d %llu", i * PMM_PAGE_SIZE, 4000000000U - i,
+                -(int32_t)i, 0x123456789ULL * i);
+    }
+    printk_test("sprintf: %d cycles per call\n",
+                (uint32_t)(cpu_rdtsc() - start) / 1000);
+    return;
+}
+
 bool test_libc(void) {
+    bool erms = cpu_has_erms();
+    test_string_str();
+    test_sprintf();
+    if (fpu_available() == true) {
+        test_string_check();
+        test_string_bench("sse2");
+        // 超过 FPU_NT_THRESHOLD 时使用非临时存储
+        uint32_t len = FPU_NT_THRESHOLD + 100;
+        uint8_t *src = kmalloc(len + 32, KMALLOC_NORMAL);
+        uint8_t *dst = kmalloc(len + 32, KMALLOC_NORMAL);
+        assert(src != NULL && dst != NULL, "test_libc kmalloc error\n");
+        for (uint32_t i = 0; i < len + 32; i++) {
+            src[i] = i * 13 + 5;
+        }
+        test_string_check_len(dst, src, 3, len);
+        kfree(src);
+        kfree(dst);
+        string_set_simd(NULL);
+    }
+    test_string_check();
+    test_string_bench(erms ? "erms" : "movsd");
+    // 支持 ERMS 时同时测试 rep movsd 实现
+    if (erms == true) {
+        string_init(false);
+        test_string_check();
+        test_string_bench("movsd");
+        string_init(true);
+    }
+    if (fpu_available() == true) {
+        string_set_simd(&fpu_simd_string);
+    }
     printk_test("libc test done.\n");
     return true;
 }
 
+bool test_binlog(void) {
+    assert(BINLOG_SIZE() == 0 && BINLOG_SIZE((char)1, 2ULL, "s") == 16,
+           "BINLOG_SIZE() error\n");
+    uint32_t dropped = binlog_dropped();
+    binlog_flush();
+    binlog("binlog: no args\n");
+    binlog("binlog: %s %c %d 0x%016llX\n", "str", 'c', -1,
+           0x0123456789ABCDEFULL);
+    // 记录与格式化的耗时
+    uint64_t start = cpu_rdtsc();
+    for (uint32_t i = 0; i < 8; i++) {
+        binlog("binlog: 0x%08X %u %d\n", i * PMM_PAGE_SIZE, i, -(int32_t)i);
+    }
+    uint32_t record = (uint32_t)(cpu_rdtsc() - start) / 8;
+    start           = cpu_rdtsc();
+    uint32_t count  = binlog_flush();
+    uint32_t format = (uint32_t)(cpu_rdtsc() - start);
+    assert(count == 10 && binlog_dropped() == dropped,
+           "binlog_flush() error\n");
+    format /= count;
+    assert(binlog_flush() == 0, "binlog_flush() empty error\n");
+    printk_test("binlog: %d cycles per record, %d cycles per flushed line\n",
+                record, format);
+    printk_test("binlog test done.\n");
+    return true;
+}
+
+// test_klog_sink 收到的测试记录
+static uint32_t test_klog_count;
+static uint32_t test_klog_seq;
+static bool     test_klog_ok;
+
+static void test_klog_write(klog_sink_t *sink __UNUSED__,
+                            const klog_record_t *rec) {
+    if (rec->len < 5 || memcmp(rec->text, "klog:", 5) != 0) {
+        return;
+    }
+    // 序号连续，级别与标志正确
+    if ((test_klog_count > 0 && rec->seq != test_klog_seq + 1) ||
+        rec->level != KLOG_TEST || (rec->flags & KLOG_PREFIX) == 0) {
+        test_klog_ok = false;
+    }
+    test_klog_seq = rec->seq;
+    test_klog_count++;
+    return;
+}
+
+// 直接写入 KLOG_TEST 记录，不受编译时级别与子系统级别影响
+static void test_klog_printf(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    klog_vwrite(KLOG_TEST, KLOG_PREFIX, COL_TEST, fmt, args);
+    va_end(args);
+    return;
+}
+
+static klog_sink_t test_klog_sink = {
+    .klog_sink_name  = "test",
+    .klog_sink_level = KLOG_DEBUG,
+    .klog_sink_write = test_klog_write,
+};
+
+bool test_klog(void) {
+    test_klog_count = 0;
+    test_klog_ok    = true;
+    klog_register_sink(&test_klog_sink);
+    klog_sink_set_level(&test_klog_sink, KLOG_DEBUG);
+    klog_set_deferred(true);
+    // 延迟模式下写入只进入缓冲区
+    uint64_t start = cpu_rdtsc();
+    for (uint32_t i = 0; i < 8; i++) {
+        test_klog_printf("klog: 0x%08X %u\n", i * PMM_PAGE_SIZE, i);
+    }
+    uint32_t record = (uint32_t)(cpu_rdtsc() - start) / 8;
+    uint32_t before = test_klog_count;
+    start           = cpu_rdtsc();
+    uint32_t count  = klog_flush();
+    uint32_t flush  = (uint32_t)(cpu_rdtsc() - start);
+    klog_set_deferred(false);
+    klog_unregister_sink(&test_klog_sink);
+    assert(before == 0, "klog deferred error\n");
+    assert(count == 8 && test_klog_count == 8 && test_klog_ok == true,
+           "klog_flush() error\n");
+    flush /= count;
+    assert(klog_flush() == 0, "klog_flush() empty error\n");
+    // 级别高于输出设备级别的记录不交给该设备
+    klog_register_sink(&test_klog_sink);
+    klog_sink_set_level(&test_klog_sink, KLOG_ERR);
+    test_klog_printf("klog: filtered\n");
+    klog_unregister_sink(&test_klog_sink);
+    assert(test_klog_count == 8, "klog sink level error\n");
+    // 子系统被关闭时不计算参数
+    uint32_t mask[KLOG_LEVEL_MAX];
+    memcpy(mask, klog_mask, sizeof(mask));
+    uint32_t eval = 0;
+    klog_register_sink(&test_klog_sink);
+    klog_sink_set_level(&test_klog_sink, KLOG_DEBUG);
+    klog_sys_set_level(KLOG_SYS_TEST, KLOG_ERR);
+    printk_test("klog: filtered %u\n", eval++);
+    klog_unregister_sink(&test_klog_sink);
+    memcpy(klog_mask, mask, sizeof(mask));
+    assert(test_klog_count == 8 && eval == 0, "klog subsystem level error\n");
+    printk_test("klog: %d cycles per record, %d cycles per flushed record\n",
+                record, flush);
+    printk_test("klog test done.\n");
+    return true;
+}
+
 // TODO: 完善测试
 bool test_pmm(void) {
     ptr_t    allc_addr1   = 0;
@@ -101,12 +411,15 @@ bool test_pmm(void) {
     int *normal_end = (void *)(NORMAL_START_ADDR + NORMAL_SIZE - 0x4);
     *normal_end     = 0xcd;
     assert(*normal_end == 0xcd, "normal_end error!\n");
-    int *highmem_start = (void *)(HIGHMEM_START_ADDR);
+    // HIGHMEM 没有直接映射，需要临时映射后访问
+    int *highmem_start = kmap_atomic(HIGHMEM_START_ADDR);
     *highmem_start     = 0x233;
     assert(*highmem_start == 0x233, "highmem_start error!\n");
-    int *highmem_end = (void *)(HIGHMEM_START_ADDR + HIGHMEM_SIZE - 0x4);
+    kunmap_atomic(highmem_start);
+    int *highmem_end = kmap_atomic(HIGHMEM_START_ADDR + HIGHMEM_SIZE - 0x4);
     *highmem_end     = 0xcd;
     assert(*highmem_end == 0xcd, "highmem_end error!\n");
+    kunmap_atomic(highmem_end);
 
     // 极限测试
 
@@ -114,6 +427,297 @@ bool test_pmm(void) {
     return true;
 }
 
+// 用于 slab 测试的对象
+typedef struct test_obj {
+    uint32_t magic;
+    uint8_t  data[20];
+} test_obj_t;
+
+static void test_obj_ctor(void *obj) {
+    ((test_obj_t *)obj)->magic = 0x233;
+    return;
+}
+
+bool test_slab(void) {
+    uint32_t      normal_free = pmm_free_pages_count(NORMAL);
+    kmem_cache_t *cache =
+        kmem_cache_create("test_obj", sizeof(test_obj_t), 0, test_obj_ctor);
+    assert(cache != NULL, "kmem_cache_create() error\n");
+    // 超过一个 slab 的对象数量
+    uint32_t     count = cache->num * 2 + 1;
+    test_obj_t **objs  = vmalloc(count * sizeof(test_obj_t *));
+    for (uint32_t i = 0; i < count; i++) {
+        objs[i] = kmem_cache_alloc(cache);
+        assert(objs[i] != NULL && ((ptr_t)objs[i] & (SLAB_MIN_ALIGN - 1)) == 0,
+               "kmem_cache_alloc() error\n");
+        assert(objs[i]->magic == 0x233, "kmem_cache ctor error\n");
+        assert(slab_get(objs[i]) != NULL && slab_get(objs[i])->cache == cache,
+               "slab_get() error\n");
+        if (i > 0) {
+            assert(objs[i] != objs[i - 1], "kmem_cache_alloc() dup\n");
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        kmem_cache_free(cache, objs[i]);
+    }
+    // 最近释放的对象被优先重用
+    test_obj_t *obj = kmem_cache_alloc(cache);
+    assert(obj == objs[count - 1], "kmem_cache magazine error\n");
+    kmem_cache_free(cache, obj);
+    vfree(objs);
+    kmem_cache_destroy(cache);
+    // 第一个 cache 描述符所在的 slab 会被保留
+    assert(pmm_free_pages_count(NORMAL) + 1 >= normal_free,
+           "kmem_cache_destroy() error\n");
+    printk_test("slab test done.\n");
+    return true;
+}
+
+bool test_kmalloc(void) {
+    // 按 2 的幂向上取整
+    uint8_t *p1 = kmalloc(24, KMALLOC_ZERO);
+    assert(p1 != NULL && ksize(p1) == 32, "kmalloc(24) error\n");
+    for (uint32_t i = 0; i < 24; i++) {
+        assert(p1[i] == 0, "kmalloc(KMALLOC_ZERO) error\n");
+        p1[i] = i;
+    }
+    // 容量足够时原地扩展
+    assert(krealloc(p1, 32, KMALLOC_NORMAL) == p1, "krealloc(32) error\n");
+    uint8_t *p2 = krealloc(p1, 100, KMALLOC_NORMAL);
+    assert(p2 != NULL && ksize(p2) == 128, "krealloc(100) error\n");
+    for (uint32_t i = 0; i < 24; i++) {
+        assert(p2[i] == i, "krealloc() copy error\n");
+    }
+    kfree(p2);
+    // 大块内存直接从 pmm 分配
+    uint32_t normal_free = pmm_free_pages_count(NORMAL);
+    uint8_t *p3          = kmalloc(3 * PMM_PAGE_SIZE, KMALLOC_NORMAL);
+    assert(p3 != NULL && ksize(p3) >= 3 * PMM_PAGE_SIZE,
+           "kmalloc(large) error\n");
+    p3[3 * PMM_PAGE_SIZE - 1] = 0xcd;
+    kfree(p3);
+    assert(normal_free == pmm_free_pages_count(NORMAL),
+           "kfree(large) error\n");
+    assert(kmalloc(0, KMALLOC_NORMAL) == NULL, "kmalloc(0) error\n");
+    // 加上头部后溢出的大小
+    assert(kmalloc((size_t)-PMM_PAGE_SIZE, KMALLOC_NORMAL) == NULL &&
+               kmalloc((size_t)-1, KMALLOC_NORMAL) == NULL,
+           "kmalloc(overflow) error\n");
+    // 调试模式
+    kmalloc_set_manage(&kmalloc_debug_manage);
+    uint32_t errors = kmalloc_debug_errors();
+    uint8_t *p4     = kmalloc(20, KMALLOC_NORMAL);
+    assert(p4 != NULL && ksize(p4) == 20, "kmalloc_debug error\n");
+    kfree(p4);
+    assert(kmalloc_debug_errors() == errors, "kmalloc_debug error\n");
+    // 越界写入
+    p4     = kmalloc(20, KMALLOC_NORMAL);
+    p4[20] = 0;
+    kfree(p4);
+    assert(kmalloc_debug_errors() == errors + 1,
+           "kmalloc_debug redzone error\n");
+    // 释放后写入，在重新分配时发现
+    p4[0]       = 0;
+    uint8_t *p5 = kmalloc(20, KMALLOC_NORMAL);
+    assert(p5 == p4 && kmalloc_debug_errors() == errors + 2,
+           "kmalloc_debug use after free error\n");
+    kfree(p5);
+    kfree(p5);
+    assert(kmalloc_debug_errors() == errors + 3,
+           "kmalloc_debug double free error\n");
+    kmalloc_set_manage(&kmalloc_normal_manage);
+    printk_test("kmalloc test done.\n");
+    return true;
+}
+
+bool test_arena(void) {
+    uint32_t normal_free = pmm_free_pages_count(NORMAL);
+    arena_t  arena;
+    arena_init(&arena);
+    uint32_t *p1 = arena_alloc(&arena, 5);
+    uint32_t *p2 = arena_alloc(&arena, 8);
+    assert(p1 != NULL && (ptr_t)p2 == (ptr_t)p1 + ARENA_ALIGN,
+           "arena_alloc() error\n");
+    arena_mark_t mark = arena_mark(&arena);
+    // 超出一块的分配会申请新块
+    for (uint32_t i = 0; i < 3; i++) {
+        uint8_t *p3 = arena_alloc(&arena, PMM_PAGE_SIZE / 2);
+        assert(p3 != NULL, "arena_alloc(PMM_PAGE_SIZE / 2) error\n");
+    }
+    assert(arena_alloc(&arena, 3 * PMM_PAGE_SIZE) != NULL,
+           "arena_alloc(large) error\n");
+    // 对齐或计算页数时溢出的大小
+    assert(arena_alloc(&arena, (size_t)-1) == NULL &&
+               arena_alloc(&arena, (size_t)-PMM_PAGE_SIZE) == NULL,
+           "arena_alloc(overflow) error\n");
+    // 回退后从 mark 处继续分配
+    arena_reset(&arena, mark);
+    assert(arena_alloc(&arena, 8) == (void *)mark.cur, "arena_reset() error\n");
+    arena_destroy(&arena);
+    assert(normal_free == pmm_free_pages_count(NORMAL),
+           "arena_destroy() error\n");
+    printk_test("arena test done.\n");
+    return true;
+}
+
+// memprof 测试中被全局变量引用的对象
+static void **memprof_test_ref;
+
+bool test_memprof(void) {
+    bool enabled = memprof_enabled;
+    memprof_enable(true);
+    // 全局变量引用的对象，以及只被该对象引用的对象
+    memprof_test_ref    = kmalloc(32, KMALLOC_NORMAL);
+    memprof_test_ref[0] = kmalloc(48, KMALLOC_NORMAL);
+    // 地址取反后保存，扫描时找不到引用
+    ptr_t hidden = ~(ptr_t)kmalloc(64, KMALLOC_NORMAL);
+    assert(memprof_leak_check() == 1, "memprof_leak_check() error\n");
+    memprof_dump();
+    kfree((void *)~hidden);
+    kfree(memprof_test_ref[0]);
+    kfree(memprof_test_ref);
+    memprof_test_ref = NULL;
+    assert(memprof_leak_check() == 0, "memprof_leak_check() free error\n");
+    memprof_enable(enabled);
+    printk_test("memprof test done.\n");
+    return true;
+}
+
+bool test_vmalloc(void) {
+    // 分配不足一页的部分按一页计算
+    size_t    size = 5 * VMM_PAGE_SIZE + 1;
+    uint32_t *addr = vmalloc(size);
+    assert(addr != NULL, "vmalloc(size) error\n");
+    assert((ptr_t)addr >= VMM_VMALLOC_START &&
+               (ptr_t)addr + size <= VMM_VMALLOC_END,
+           "vmalloc address out of range\n");
+    assert(vmalloc((size_t)-1) == NULL, "vmalloc(overflow) error\n");
+    // 每一页都有映射，且可以读写
+    for (uint32_t i = 0; i < 6; i++) {
+        ptr_t pa = 0;
+        assert(vmm_get_mapping(pgd_kernel, (ptr_t)addr + i * VMM_PAGE_SIZE,
+                               &pa) == true,
+               "vmalloc page not mapped\n");
+    }
+    for (uint32_t i = 0; i < size / sizeof(uint32_t); i++) {
+        addr[i] = i;
+    }
+    for (uint32_t i = 0; i < size / sizeof(uint32_t); i++) {
+        assert(addr[i] == i, "vmalloc read back error\n");
+    }
+    // 递归映射区中的页表项与页表中的一致
+    pte_t *pte = (pte_t *)(pgd_kernel[VMM_PGD_INDEX(addr)] & VMM_PAGE_MASK);
+    assert(*VMM_RECURSIVE_PTE(addr) == pte[VMM_PTE_INDEX(addr)],
+           "VMM_RECURSIVE_PTE(addr) error\n");
+    assert(vmm_protect(pgd_kernel, (ptr_t)addr, VMM_PAGE_PRESENT) == true &&
+               (*VMM_RECURSIVE_PTE(addr) & VMM_PAGE_RW) == 0,
+           "vmm_protect(addr) error\n");
+    assert(addr[0] == 0, "vmm_protect(addr) read error\n");
+    vmm_protect(pgd_kernel, (ptr_t)addr, VMM_PAGE_KERNEL);
+    vfree(addr);
+    // 刷新 TLB 后虚拟地址可以被重用
+    vmalloc_purge();
+    // 页表已经建立，此后物理页数量应保持不变
+    uint32_t normal_free  = pmm_free_pages_count(NORMAL);
+    uint32_t highmem_free = pmm_free_pages_count(HIGHMEM);
+    uint32_t *addr2       = vmalloc(size);
+    assert(addr2 == addr, "vmalloc_purge() error\n");
+    vfree(addr2);
+    assert(normal_free + highmem_free == pmm_free_pages_count(NORMAL) +
+                                             pmm_free_pages_count(HIGHMEM),
+           "vfree(addr2) error\n");
+    vmalloc_purge();
+    // 设备内存不能合并为大页
+    void *io = ioremap(0xB8000, VMM_PAGE_SIZE);
+    assert(io != NULL && vmalloc_set_huge(io, true) == false,
+           "vmalloc_set_huge(ioremap) error\n");
+    iounmap(io);
+    vmalloc_purge();
+    // 合并为大页后内容不变
+    if (vmm_has_large_page() == true) {
+        vmalloc_stat_t stat;
+        vmalloc_get_stat(&stat);
+        // 页表页可能在缓存与 pmm 之间移动
+        normal_free  = pmm_free_pages_count(NORMAL);
+        normal_free += vmm_pgtable_pool_count();
+        highmem_free = pmm_free_pages_count(HIGHMEM);
+        uint32_t *huge       = vmalloc_huge(VMM_LARGE_PAGE_SIZE);
+        uint32_t  huge_words = VMM_LARGE_PAGE_SIZE / sizeof(uint32_t);
+        assert(((ptr_t)huge & ~VMM_LARGE_PAGE_MASK) == 0,
+               "vmalloc_huge() error\n");
+        for (uint32_t i = 0; i < huge_words; i += 1024) {
+            huge[i] = i;
+        }
+        assert(vmalloc_collapse() == true &&
+                   (pgd_kernel[VMM_PGD_INDEX(huge)] & VMM_PAGE_LARGE),
+               "vmalloc_collapse() error\n");
+        for (uint32_t i = 0; i < huge_words; i += 1024) {
+            assert(huge[i] == i, "vmalloc_collapse() read back error\n");
+        }
+        vmalloc_stat_t stat2;
+        vmalloc_get_stat(&stat2);
+        assert(stat2.collapse_success == stat.collapse_success + 1 &&
+                   stat2.large_pages == stat.large_pages + 1,
+               "vmalloc_get_stat() error\n");
+        vfree(huge);
+        vmalloc_purge();
+        assert(normal_free == pmm_free_pages_count(NORMAL) +
+                                  vmm_pgtable_pool_count() &&
+                   highmem_free == pmm_free_pages_count(HIGHMEM),
+               "vfree(huge) error\n");
+    }
+    printk_test("vmalloc test done.\n");
+    return true;
+}
+
+bool test_pgtable(void) {
+    vmm_pgtable_refill();
+    uint32_t count = vmm_pgtable_pool_count();
+    pte_t *  pte   = vmm_pgtable_alloc();
+    assert(pte != NULL && vmm_pgtable_pool_count() == count - 1,
+           "vmm_pgtable_alloc() error\n");
+    for (uint32_t i = 0; i < VMM_ENTRIES_PER_TABLE; i++) {
+        assert(pte[i] == 0, "vmm_pgtable_alloc() not zeroed\n");
+        pte[i] = i;
+    }
+    vmm_pgtable_free(pte);
+    assert(vmm_pgtable_pool_count() == count, "vmm_pgtable_free() error\n");
+    // 放回缓存的页表页已被清零
+    pte = vmm_pgtable_alloc();
+    for (uint32_t i = 0; i < VMM_ENTRIES_PER_TABLE; i++) {
+        assert(pte[i] == 0, "vmm_pgtable_free() not zeroed\n");
+    }
+    vmm_pgtable_free(pte);
+    printk_test("pgtable test done.\n");
+    return true;
+}
+
+bool test_kmap(void) {
+    // 低端内存直接返回直接映射区地址
+    assert(kmap(NORMAL_START_ADDR) == (void *)NORMAL_START_ADDR,
+           "kmap(lowmem) error\n");
+    ptr_t pa = pmm_alloc_page(1, HIGHMEM);
+    assert(pa != (ptr_t)-1, "pmm_alloc_page(1, HIGHMEM) error\n");
+    // 同一物理页的持久映射被共享
+    uint32_t *addr1 = kmap(pa + 0x10);
+    uint32_t *addr2 = kmap(pa);
+    assert(addr1 != NULL && (ptr_t)addr1 - 0x10 == (ptr_t)addr2,
+           "kmap(pa) error\n");
+    *addr1 = 0x233;
+    // 嵌套的原子映射
+    uint32_t *addr3 = kmap_atomic(pa + 0x10);
+    uint32_t *addr4 = kmap_atomic(pa + 0x10);
+    assert(addr3 != addr4 && *addr3 == 0x233 && *addr4 == 0x233,
+           "kmap_atomic(pa) error\n");
+    kunmap_atomic(addr4);
+    kunmap_atomic(addr3);
+    kunmap(addr2);
+    kunmap(addr1);
+    pmm_free_page(pa, 1, HIGHMEM);
+    printk_test("kmap test done.\n");
+    return true;
+}
+
 #ifdef __cplusplus
 }
 #endif